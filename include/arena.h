@@ -0,0 +1,109 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Counters exposed by an Arena, mainly to verify that the hot path does not
+ * hit the system allocator once the arena is warm.
+ */
+struct ArenaStats {
+    std::size_t allocations = 0;       // calls to Arena::allocate since construction
+    std::size_t bytesRequested = 0;    // sum of the sizes passed to Arena::allocate
+    std::size_t systemAllocations = 0; // chunks obtained from the OS (malloc/mmap)
+    std::size_t systemFrees = 0;       // chunks given back to the OS
+    std::size_t bytesReserved = 0;     // bytes currently owned by the arena
+    std::size_t highWater = 0;         // largest number of bytes in use between two resets
+    std::size_t resets = 0;
+};
+
+/**
+ * Bump allocator that owns matrix storage and kernel scratch buffers.
+ * Every block is aligned to kAlignment bytes (one cache line, one AVX-512 register).
+ * Memory is never freed block by block: reset() rewinds the arena between jobs and
+ * keeps the chunks, so a long-running process does no malloc/free in the hot path.
+ */
+class Arena {
+public:
+    static constexpr std::size_t kAlignment = 64;
+    static constexpr std::size_t kDefaultChunkBytes = std::size_t(4) << 20;
+
+    /**
+     * Position inside the arena, used to give back scratch memory at the end of a kernel.
+     */
+    struct Mark {
+        std::size_t chunk;
+        std::size_t offset;
+    };
+
+    /**
+     * RAII helper: everything allocated while a Scope is alive is released when it ends.
+     */
+    class Scope {
+    public:
+        explicit Scope(Arena& arena) : arena_(arena), mark_(arena.mark()) {}
+        ~Scope() { arena_.rewind(mark_); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        Arena& arena_;
+        Mark mark_;
+    };
+
+    /**
+     * @param chunkBytes minimum size of every chunk requested to the OS.
+     * @param hugePages back the chunks with (transparent) huge pages when available.
+     */
+    explicit Arena(std::size_t chunkBytes = kDefaultChunkBytes, bool hugePages = false);
+    ~Arena();
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /**
+     * @return a kAlignment-aligned block of at least `bytes` bytes, valid until the next reset/rewind.
+     */
+    void* allocate(std::size_t bytes);
+
+    template <typename T>
+    T* allocateArray(std::size_t count) {
+        return static_cast<T*>(allocate(count * sizeof(T)));
+    }
+
+    Mark mark() const;
+    void rewind(const Mark& mark);
+
+    /**
+     * Rewind the whole arena. If the previous job spilled over several chunks they are
+     * merged into a single one, so that the next job of the same size fits without growing.
+     */
+    void reset();
+
+    /**
+     * Give every chunk back to the OS.
+     */
+    void release();
+
+    std::size_t bytesInUse() const;
+    const ArenaStats& stats() const { return stats_; }
+    bool hugePages() const { return hugePages_; }
+
+private:
+    struct Chunk {
+        char* data;
+        std::size_t size;
+        std::size_t used;
+        bool mapped;
+    };
+
+    Chunk newChunk(std::size_t bytes);
+    void freeChunk(Chunk& chunk);
+
+    std::vector<Chunk> chunks_;
+    std::size_t current_ = 0;
+    std::size_t chunkBytes_;
+    bool hugePages_;
+    ArenaStats stats_;
+};
+
+#endif // ARENA_H
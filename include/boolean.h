@@ -0,0 +1,103 @@
+#ifndef BOOLEAN_H
+#define BOOLEAN_H
+
+#include "arena.h"
+#include "distributed.h"
+#include "matrix.h"
+#include <mpi/mpi.h>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+/**
+ * Row-major 0/1 matrix packed 64 entries per word, storage owned by an Arena.
+ * Entry (i, j) is bit j % 64 of word j / 64 of row i. Rows are padded to `words` words
+ * (a multiple of 8, so every row starts on a 64-byte boundary) and the padding bits are
+ * always 0, which lets the kernels work on whole words.
+ * Like Matrix, the struct is a handle: copying it does not copy the bits.
+ */
+struct BitMatrix {
+    int rows = 0;
+    int cols = 0;
+    int words = 0;
+    std::uint64_t* data = nullptr;
+
+    std::uint64_t* row(int i) { return data + static_cast<std::size_t>(i) * words; }
+    const std::uint64_t* row(int i) const { return data + static_cast<std::size_t>(i) * words; }
+    bool get(int i, int j) const { return (row(i)[j / 64] >> (j % 64)) & 1; }
+    void set(int i, int j) { row(i)[j / 64] |= std::uint64_t(1) << (j % 64); }
+
+    std::size_t storageSize() const { return static_cast<std::size_t>(rows) * words; }
+};
+
+/**
+ * @return words per row of a BitMatrix with `cols` columns, padding included.
+ */
+int paddedWords(int cols);
+
+/**
+ * Allocate a rows x cols bit matrix in the arena with every bit cleared.
+ */
+BitMatrix allocateBitMatrix(Arena& arena, int rows, int cols);
+
+/**
+ * Rows [begin, begin + count) of M, sharing M's storage.
+ */
+BitMatrix rowBlock(const BitMatrix& M, int begin, int count);
+
+/**
+ * Bit (i, j) set where M(i, j) != 0.
+ */
+BitMatrix packBits(const Matrix& M, Arena& arena);
+
+/**
+ * M(i, j) = bit (i, j); M must be rows x cols of `bits`.
+ */
+void unpackBits(const BitMatrix& bits, Matrix& M);
+
+BitMatrix transposeBits(const BitMatrix& M, Arena& arena);
+
+/**
+ * Read a 0/1 matrix in the project text format (first line "rows cols", then the elements)
+ * straight into packed form.
+ * @return false if the file cannot be opened, is truncated or holds something else than 0 and 1.
+ */
+bool readBitMatrixFromFile(const std::string& filename, Arena& arena, BitMatrix& matrix);
+
+/**
+ * Print the matrix like writeMatrix does (0 and 1 separated by spaces, one row per line).
+ */
+void writeBitMatrix(std::ostream& out, const BitMatrix& M);
+
+/**
+ * Boolean product over the (OR, AND) semiring: C(i, j) = OR_k A(i, k) AND B(k, j).
+ * B is transposed into `workspace`, then every C(i, j) is an OR of ANDs of the words of
+ * row i of A and row j of B^T, stopping at the first non-zero word, with AVX-512 or AVX2
+ * when the CPU has them. Threaded over the rows of C, which must be rows(A) x cols(B).
+ */
+void multiplyBoolean(const BitMatrix& A, const BitMatrix& B, BitMatrix& C, Arena& workspace);
+
+/**
+ * multiplyBoolean with B already transposed (Bt is cols(B) x rows(B)).
+ */
+void multiplyBooleanTransposed(const BitMatrix& A, const BitMatrix& Bt, BitMatrix& C);
+
+/**
+ * Integer product of two 0/1 matrices, C(i, j) = popcount(row i of A AND column j of B):
+ * the number of k with both bits set (paths of length 2 in a graph). Uses AVX-512 VPOPCNTDQ
+ * or the popcnt instruction when the CPU has them. C is a Matrix rows(A) x cols(B).
+ */
+void countBoolean(const BitMatrix& A, const BitMatrix& B, Matrix& C, Arena& workspace);
+
+/**
+ * Row-block distributed Boolean product; A and B are significant on rank 0 only and
+ * A.cols must equal B.rows (the caller checks it).
+ * Rank 0 transposes B once and broadcasts B^T, the packed rows of A are scattered in
+ * balanced blocks and the packed rows of C gathered back, so every message is 32 times
+ * smaller than with ints. `timings`, if given, receives the phase times of the calling rank.
+ * @return C on rank 0 (allocated in `storage`), an empty matrix on the other ranks.
+ */
+BitMatrix distributedMultiplyBoolean(const BitMatrix& A, const BitMatrix& B, MPI_Comm comm,
+                                     Arena& storage, PhaseTimes* timings = nullptr);
+
+#endif // BOOLEAN_H
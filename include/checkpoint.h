@@ -0,0 +1,104 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "bounded_queue.h"
+#include "matrix.h"
+#include "result_cache.h"
+#include <mpi/mpi.h>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Checkpoint/restart of a distributed product.
+ *
+ * C is cut in tiles of `tileRows` global rows; the tile size is stored in
+ * <directory>/checkpoint.meta together with the operand key and the shape, so a
+ * resumed run can use any number of ranks: every rank just restores the tiles that
+ * fall in its share. Each completed tile is written by a background thread of the
+ * rank that computed it, as <directory>/tile_<index>.bin published with rename(),
+ * hence the set of tile files is always a consistent checkpoint.
+ * Completed tiles are handed to the writer every `intervalSeconds` (0: immediately).
+ * Between begin() and finish() SIGTERM and SIGINT (preemption, scancel) make the writer
+ * save every completed tile, including those still waiting for the interval, before the
+ * signal is raised again with its default action.
+ */
+class Checkpointer {
+public:
+    struct Stats {
+        int tilesRestored = 0;
+        int tilesWritten = 0;
+        std::uint64_t bytesWritten = 0;
+        double writeSeconds = 0;    // time spent by the background writer
+        double restoreSeconds = 0;  // time spent reading tiles back
+    };
+
+    /**
+     * The writer thread may run on any of `writerCpus`, normally the cpus of the rank (see
+     * pinHelperThread), rather than on the cpu of OpenMP thread 0. Empty: inherited.
+     */
+    Checkpointer(std::string directory, double intervalSeconds, bool resume,
+                 std::vector<int> writerCpus = std::vector<int>());
+    ~Checkpointer();
+    Checkpointer(const Checkpointer&) = delete;
+    Checkpointer& operator=(const Checkpointer&) = delete;
+
+    /**
+     * Collective over `comm`. `key` is significant on rank 0 only.
+     * On resume rank 0 keeps the stored tile size if the stored key and shape match (and deletes
+     * tile files of other operands), otherwise the checkpoint is started from scratch with
+     * `defaultTileRows` and every tile file in the directory is deleted.
+     * @return the tile size agreed by every rank.
+     */
+    int begin(MPI_Comm comm, const CacheKey& key, int rowsA, int colsB, int defaultTileRows);
+
+    /**
+     * Load tile `tile` into `tileC` (padding zeroed) if a valid copy exists.
+     */
+    bool restore(int tile, Matrix& tileC);
+
+    /**
+     * Record that `tileC` is final. Its storage must stay untouched until finish().
+     */
+    void completed(int tile, const Matrix& tileC);
+
+    /**
+     * Write the tiles still waiting for the next interval and stop the writer thread.
+     */
+    void finish();
+
+    void report(std::ostream& out, int rank) const;
+    const Stats& stats() const { return stats_; }
+
+private:
+    struct PendingTile {
+        int index;
+        Matrix tile;
+    };
+
+    std::string tilePath(int tile) const;
+    void writeTile(const PendingTile& pending);
+    void flush();
+    void runWriter();
+
+    std::string directory_;
+    double intervalSeconds_;
+    bool resume_;
+    std::vector<int> writerCpus_;
+    bool resumed_ = false;
+    std::string key_;
+    int cols_ = 0;
+    int tileRows_ = 0;
+    std::vector<PendingTile> pending_;  // shared with the writer when a signal arrives
+    std::mutex pendingMutex_;
+    BoundedQueue<PendingTile> queue_;
+    std::thread writer_;
+    std::chrono::steady_clock::time_point lastFlush_;
+    Stats stats_;
+};
+
+#endif // CHECKPOINT_H
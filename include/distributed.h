@@ -0,0 +1,111 @@
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+#include "arena.h"
+#include "kernels.h"
+#include "matrix.h"
+#include "semiring.h"
+#include <cstdint>
+#include <mpi/mpi.h>
+
+class Checkpointer;
+class KernelRegistry;
+class PerfCounters;
+class ProgressThread;
+
+/**
+ * Wall time of the phases of distributedMultiply on the calling rank, in seconds.
+ */
+struct PhaseTimes {
+    double distribute = 0;  // sizes, A and B to every rank
+    double compute = 0;     // local kernel (and checkpoint tiles)
+    double collect = 0;     // C back to rank 0
+};
+
+/**
+ * Share of the dynamic schedule taken by the calling rank.
+ */
+struct ScheduleReport {
+    int tiles = 0;
+    int rows = 0;
+};
+
+struct DistributedOptions {
+    bool interleaveB = false;              // spread B over the NUMA nodes (see placement.h)
+    bool sharedB = false;                  // one copy of B per node (see node_shared.h)
+    bool oneSided = false;                 // ranks fetch A and B with MPI_Get instead of collectives
+    bool dynamic = false;                  // ranks claim guided row ranges from a shared counter
+    Checkpointer* checkpointer = nullptr;  // save/restore tiles of C (see checkpoint.h)
+    KernelReport* report = nullptr;        // filled with the kernel chosen by this rank
+    PhaseTimes* timings = nullptr;         // filled with the phase times of this rank
+    ScheduleReport* schedule = nullptr;    // filled with this rank's share of the dynamic schedule
+    PerfCounters* counters = nullptr;      // hardware counts of every phase and kernel call (see perf_counters.h)
+    KernelRegistry* registry = nullptr;    // tuned kernel variants for the general case (see kernel_registry.h)
+    std::uint32_t modulus = 0;             // when not 0, C = A * B mod modulus (see modular.h)
+    SemiringKind semiring = SemiringKind::PlusTimes;  // other than PlusTimes: multiplySemiring (see semiring.h)
+    ProgressThread* progress = nullptr;    // stream the row blocks in chunks while computing (see progress.h)
+};
+
+/**
+ * Derived datatype of the elements of M in place, M a whole matrix or a view (see
+ * subMatrix): M.rows blocks of M.cols ints, M.stride ints apart. Send or receive one of it
+ * at M.data and the block moves without being packed; the two sides may use different
+ * strides. Committed, the caller frees it with MPI_Type_free.
+ */
+MPI_Datatype matrixDatatype(const Matrix& M);
+
+/**
+ * Row-block distributed product C = A * B.
+ * A and B are significant on rank 0 only: the rows of A are scattered (balanced blocks),
+ * B is broadcast, every rank multiplies its block with the threaded kernel and the blocks
+ * of C are gathered back on rank 0.
+ * Every rank picks its kernel with multiplyAuto, so structure and value range are
+ * exploited block by block.
+ * Local blocks are first touched by the threads that compute on them; with `interleaveB`
+ * the copy of B, read by every thread, is spread over the NUMA nodes instead.
+ * With `sharedB` B is broadcast among the node leaders only, into a shared memory window
+ * that the other ranks of the node read in place.
+ * With `oneSided` rank 0 exposes A, B and C in RMA windows: every rank pulls its rows of A
+ * and all of B with MPI_Get and pushes its rows of C with MPI_Put under shared passive
+ * target locks, so no rank waits for the others until the windows are freed.
+ * With `dynamic` the rows are not split in advance: ranks repeatedly claim the next range of
+ * rows (guided sizes, see guidedRanges) with MPI_Fetch_and_op on a counter held by rank 0 and
+ * move the rows with MPI_Get / MPI_Put, so faster ranks take more ranges. Not used with a
+ * checkpointer, whose tiles are assigned statically.
+ * With a `progress` thread (and without sharedB, oneSided, dynamic or a checkpointer) every
+ * row block travels in chunks: rank 0 hands the chunks of A and the receives of the chunks
+ * of C to its progress thread, every other rank computes a chunk of C as soon as its rows of
+ * A have arrived and hands it back to its own progress thread, so the transfers of A and C
+ * overlap the kernel and the broadcast of B.
+ * With a `checkpointer` the rows are dealt in whole checkpoint tiles, tiles found in a
+ * resumed checkpoint are loaded instead of computed and the others are saved as they complete.
+ * When A has fewer rows than there are ranks (GEVM, dot products) the inner dimension is split
+ * instead: every rank receives its columns of A (see matrixDatatype) and its rows of B, and
+ * the partial products are summed with MPI_Allreduce (not used with a checkpointer, whose
+ * tiles are row blocks).
+ * With a `modulus` every rank runs multiplyModular instead of multiplyAuto and the inner split
+ * sums its partial products modulo p, so C holds residues in [0, p). With another `semiring`
+ * every rank runs multiplySemiring and the inner split combines with MPI_MIN or MPI_MAX.
+ * @return C on rank 0 (allocated in `storage`), an empty matrix on the other ranks;
+ *         with the inner split every rank gets C.
+ */
+Matrix distributedMultiply(const Matrix& A, const Matrix& B, MPI_Comm comm,
+                           Arena& storage, Arena& workspace,
+                           const DistributedOptions& options = DistributedOptions());
+
+/**
+ * Distributed matrix power C = A^k (k >= 0) of a square A, with O(log k) products:
+ * binary exponentiation from the leading bit of k, squaring for every further bit and
+ * multiplying by A where the bit is set. A is significant on rank 0 only and is broadcast
+ * once. Every rank then keeps its balanced block of rows of the running power across the
+ * products, in two ping-pong buffers allocated once: a multiplication by A is purely local,
+ * a squaring allgathers the row blocks first. Nothing goes back to rank 0 until the end.
+ * Kernels, `modulus`, `semiring`, `report`, `counters` and `timings` work as in
+ * distributedMultiply (the phase times are summed over the products); the checkpointer and
+ * the sharedB, oneSided and dynamic modes are ignored. A^0 is the identity of the semiring.
+ * @return C on rank 0 (allocated in `storage`), an empty matrix on the other ranks.
+ */
+Matrix distributedPower(const Matrix& A, int k, MPI_Comm comm, Arena& storage, Arena& workspace,
+                        const DistributedOptions& options = DistributedOptions());
+
+#endif // DISTRIBUTED_H
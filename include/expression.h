@@ -0,0 +1,269 @@
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+#include "arena.h"
+#include "kernels.h"
+#include "matrix.h"
+#include "semiring.h"
+#include <algorithm>
+#include <type_traits>
+
+/**
+ * Lazy matrix expressions, evaluated with a single pass over the result:
+ *
+ *     evaluate(relu(hadamard(A * B + C * D, M) + E), R, workspace);
+ *
+ * operator*, operator+, hadamard and relu do no arithmetic, they only record their operands
+ * (Matrix handles, copied without the elements). evaluate runs one gemmFused: the products
+ * of the expression are accumulated into the same tiles of R, and the element-wise rest of
+ * the expression is applied to every tile as soon as its last product is done, while it is
+ * still in cache. No temporary matrix is allocated. Arithmetic is modulo 2^32.
+ * An expression holds at most one sum of products (so (A * B) o (C * D) does not compile).
+ */
+
+/**
+ * Operand of a product: a matrix or, through transposed(), its transpose.
+ */
+struct Operand {
+    Operand(const Matrix& matrix, Transpose trans = Transpose::No) : matrix(matrix), trans(trans) {}
+
+    Matrix matrix;
+    Transpose trans;
+};
+
+inline Operand transposed(const Matrix& M) {
+    return Operand(M, Transpose::Yes);
+}
+
+/**
+ * alpha_0 * op(A_0) * op(B_0) + ... + alpha_N-1 * op(A_N-1) * op(B_N-1).
+ * Inside an element-wise expression its value at (i, j) is the accumulated sum.
+ */
+template <int N>
+struct ProductSum {
+    GemmTerm terms[N];
+
+    int value(int sum, int, int) const { return sum; }
+};
+
+/**
+ * A matrix read element by element by the epilogue.
+ */
+struct MatrixTerm {
+    Matrix matrix;
+
+    int value(int, int i, int j) const { return matrix.at(i, j); }
+};
+
+template <typename L, typename R>
+struct SumExpr {
+    L left;
+    R right;
+
+    int value(int sum, int i, int j) const { return PlusTimes::add(left.value(sum, i, j), right.value(sum, i, j)); }
+};
+
+template <typename L, typename R>
+struct HadamardExpr {
+    L left;
+    R right;
+
+    int value(int sum, int i, int j) const { return PlusTimes::mul(left.value(sum, i, j), right.value(sum, i, j)); }
+};
+
+template <typename E>
+struct ReluExpr {
+    E operand;
+
+    int value(int sum, int i, int j) const { return std::max(operand.value(sum, i, j), 0); }
+};
+
+/**
+ * ProductCount: sums of products in an expression; TermCount: products in them.
+ */
+template <typename E>
+struct ProductCount : std::integral_constant<int, 0> {};
+template <int N>
+struct ProductCount<ProductSum<N>> : std::integral_constant<int, 1> {};
+template <typename L, typename R>
+struct ProductCount<SumExpr<L, R>> : std::integral_constant<int, ProductCount<L>::value + ProductCount<R>::value> {};
+template <typename L, typename R>
+struct ProductCount<HadamardExpr<L, R>> : std::integral_constant<int, ProductCount<L>::value + ProductCount<R>::value> {};
+template <typename E>
+struct ProductCount<ReluExpr<E>> : ProductCount<E> {};
+
+template <typename E>
+struct TermCount : std::integral_constant<int, 0> {};
+template <int N>
+struct TermCount<ProductSum<N>> : std::integral_constant<int, N> {};
+template <typename L, typename R>
+struct TermCount<SumExpr<L, R>> : std::integral_constant<int, TermCount<L>::value + TermCount<R>::value> {};
+template <typename L, typename R>
+struct TermCount<HadamardExpr<L, R>> : std::integral_constant<int, TermCount<L>::value + TermCount<R>::value> {};
+template <typename E>
+struct TermCount<ReluExpr<E>> : TermCount<E> {};
+
+template <typename E>
+struct IsExpression : std::false_type {};
+template <int N>
+struct IsExpression<ProductSum<N>> : std::true_type {};
+template <typename L, typename R>
+struct IsExpression<SumExpr<L, R>> : std::true_type {};
+template <typename L, typename R>
+struct IsExpression<HadamardExpr<L, R>> : std::true_type {};
+template <typename E>
+struct IsExpression<ReluExpr<E>> : std::true_type {};
+
+/**
+ * Node type of an operand of an element-wise operation: a Matrix becomes a MatrixTerm.
+ */
+template <typename T>
+using NodeOf = typename std::conditional<std::is_same<T, Matrix>::value, MatrixTerm, T>::type;
+
+inline MatrixTerm asNode(const Matrix& M) {
+    return MatrixTerm{M};
+}
+
+template <typename E>
+const E& asNode(const E& expression) {
+    return expression;
+}
+
+template <typename T>
+struct IsNode : std::integral_constant<bool, IsExpression<T>::value || std::is_same<T, Matrix>::value> {};
+
+/**
+ * Element-wise operations take expressions and matrices; operator+ needs at least one
+ * expression, so that Matrix + Matrix stays undefined.
+ */
+template <typename L, typename R>
+using EnableElementwise = typename std::enable_if<IsNode<L>::value && IsNode<R>::value>::type;
+
+template <typename L, typename R>
+using EnableSum = typename std::enable_if<IsNode<L>::value && IsNode<R>::value &&
+                                          (IsExpression<L>::value || IsExpression<R>::value)>::type;
+
+inline ProductSum<1> operator*(const Operand& A, const Operand& B) {
+    ProductSum<1> product;
+    product.terms[0].transA = A.trans;
+    product.terms[0].transB = B.trans;
+    product.terms[0].A = A.matrix;
+    product.terms[0].B = B.matrix;
+    return product;
+}
+
+template <int N>
+ProductSum<N> operator*(int alpha, ProductSum<N> products) {
+    for (GemmTerm& term : products.terms) {
+        term.alpha = PlusTimes::mul(alpha, term.alpha);
+    }
+    return products;
+}
+
+template <int N, int M>
+ProductSum<N + M> operator+(const ProductSum<N>& left, const ProductSum<M>& right) {
+    ProductSum<N + M> sum;
+    std::copy(left.terms, left.terms + N, sum.terms);
+    std::copy(right.terms, right.terms + M, sum.terms + N);
+    return sum;
+}
+
+template <typename L, typename R, typename = EnableSum<L, R>>
+SumExpr<NodeOf<L>, NodeOf<R>> operator+(const L& left, const R& right) {
+    static_assert(ProductCount<NodeOf<L>>::value + ProductCount<NodeOf<R>>::value <= 1,
+                  "only one sum of products per expression: write A * B + C * D, not (A * B) op (C * D)");
+    return {asNode(left), asNode(right)};
+}
+
+/**
+ * Element-wise (Hadamard) product.
+ */
+template <typename L, typename R, typename = EnableElementwise<L, R>>
+HadamardExpr<NodeOf<L>, NodeOf<R>> hadamard(const L& left, const R& right) {
+    static_assert(ProductCount<NodeOf<L>>::value + ProductCount<NodeOf<R>>::value <= 1,
+                  "only one sum of products per expression: the products cannot be fused otherwise");
+    return {asNode(left), asNode(right)};
+}
+
+/**
+ * max(x, 0) element-wise.
+ */
+template <typename E, typename = typename std::enable_if<IsExpression<E>::value>::type>
+ReluExpr<E> relu(const E& expression) {
+    return {expression};
+}
+
+template <int N>
+const GemmTerm* termsOf(const ProductSum<N>& products) {
+    return products.terms;
+}
+
+inline const GemmTerm* termsOf(const MatrixTerm&) {
+    return nullptr;
+}
+
+template <typename L, typename R>
+const GemmTerm* termsOf(const SumExpr<L, R>& e) {
+    const GemmTerm* terms = termsOf(e.left);
+    return terms != nullptr ? terms : termsOf(e.right);
+}
+
+template <typename L, typename R>
+const GemmTerm* termsOf(const HadamardExpr<L, R>& e) {
+    const GemmTerm* terms = termsOf(e.left);
+    return terms != nullptr ? terms : termsOf(e.right);
+}
+
+template <typename E>
+const GemmTerm* termsOf(const ReluExpr<E>& e) {
+    return termsOf(e.operand);
+}
+
+/**
+ * TileEpilogue::apply of an expression: every element of the tile becomes the value of
+ * the expression at its position, given the sum of products accumulated there.
+ */
+template <typename E>
+void applyExpression(const void* context, int* c, std::size_t ldc, int i0, int j0, int mc, int nc) {
+    const E& expression = *static_cast<const E*>(context);
+    for (int i = 0; i < mc; ++i) {
+        int* row = c + i * ldc;
+#pragma omp simd
+        for (int j = 0; j < nc; ++j) {
+            row[j] = expression.value(row[j], i0 + i, j0 + j);
+        }
+    }
+}
+
+/**
+ * R = expression, threaded and blocked like gemm (see gemmFused). R must have the shape of
+ * the expression and must not alias any of its matrices, except for R = products + R which
+ * accumulates into R in place (beta = 1, no epilogue).
+ */
+template <typename E>
+void evaluate(const E& expression, Matrix& R, Arena& workspace, const BlockSizes& blocks = BlockSizes()) {
+    TileEpilogue epilogue;
+    epilogue.apply = applyExpression<E>;
+    epilogue.context = &expression;
+    gemmFused(termsOf(expression), TermCount<E>::value, 0, R, workspace, blocks, epilogue);
+}
+
+template <int N>
+void evaluate(const ProductSum<N>& products, Matrix& R, Arena& workspace, const BlockSizes& blocks = BlockSizes()) {
+    gemmFused(products.terms, N, 0, R, workspace, blocks);
+}
+
+template <int N>
+void evaluate(const SumExpr<ProductSum<N>, MatrixTerm>& expression, Matrix& R, Arena& workspace,
+              const BlockSizes& blocks = BlockSizes()) {
+    if (expression.right.matrix.data == R.data) {
+        gemmFused(expression.left.terms, N, 1, R, workspace, blocks);
+        return;
+    }
+    TileEpilogue epilogue;
+    epilogue.apply = applyExpression<SumExpr<ProductSum<N>, MatrixTerm>>;
+    epilogue.context = &expression;
+    gemmFused(expression.left.terms, N, 0, R, workspace, blocks, epilogue);
+}
+
+#endif // EXPRESSION_H
@@ -0,0 +1,49 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include "matrix.h"
+#include <cstdint>
+
+enum class MatrixKind {
+    Random,           // every element uniform in [minValue, maxValue]
+    Sparse,           // nonzero with probability `density`
+    Banded,           // nonzero only for -lowerBandwidth <= j - i <= upperBandwidth
+    Identity,
+    Diagonal,
+    Symmetric,        // element (i, j) equals element (j, i)
+    LowerTriangular,
+    UpperTriangular,
+};
+
+/**
+ * Description of a synthetic matrix. Element (i, j) is a pure function of the spec and of
+ * (i, j), drawn with the counter-based generator of random.h, so any thread or rank can
+ * produce any block of rows on its own and the same seed always gives the same matrix.
+ */
+struct GeneratorSpec {
+    MatrixKind kind = MatrixKind::Random;
+    int rows = 0;
+    int cols = 0;
+    std::uint64_t seed = 1;
+    int minValue = -100;
+    int maxValue = 100;
+    double density = 0.01;
+    int lowerBandwidth = 1;
+    int upperBandwidth = 1;
+};
+
+/**
+ * @return false if `name` is not one of random, sparse, banded, identity, diagonal,
+ *         symmetric, lower, upper.
+ */
+bool parseMatrixKind(const char* name, MatrixKind& kind);
+
+int generateElement(const GeneratorSpec& spec, int i, int j);
+
+/**
+ * Fill `block` (block.cols == spec.cols) with rows [firstRow, firstRow + block.rows)
+ * of the matrix, threaded over the rows; the padding is zeroed.
+ */
+void generateRows(const GeneratorSpec& spec, int firstRow, Matrix& block);
+
+#endif // GENERATOR_H
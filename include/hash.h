@@ -0,0 +1,27 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Streaming implementation of the XXH64 hash (same output as the reference xxHash library).
+ * Used to fingerprint operands without copying them into one contiguous buffer.
+ */
+class Hash64 {
+public:
+    explicit Hash64(std::uint64_t seed = 0);
+    void update(const void* data, std::size_t bytes);
+    std::uint64_t digest() const;
+
+private:
+    std::uint64_t acc_[4];
+    std::uint64_t seed_;
+    std::uint64_t total_ = 0;
+    unsigned char buffer_[32];
+    std::size_t buffered_ = 0;
+};
+
+std::uint64_t hash64(const void* data, std::size_t bytes, std::uint64_t seed = 0);
+
+#endif // HASH_H
@@ -0,0 +1,102 @@
+#ifndef KERNEL_REGISTRY_H
+#define KERNEL_REGISTRY_H
+
+#include "arena.h"
+#include "matrix.h"
+#include "quantized.h"
+#include <functional>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * One implementation of C = A * B with its parameters baked in.
+ * It may only be used when the operands need at most `width` bits (int8 kernels need int8
+ * operands, general kernels accept anything).
+ */
+struct KernelVariant {
+    std::string name;
+    QuantizedWidth width;
+    std::function<void(const Matrix& A, const Matrix& B, Matrix& C, Arena& workspace)> run;
+};
+
+/**
+ * Kernel variants (naive, blocked with several tile sizes and row unrolls, Strassen, int16,
+ * int8) and a tuning table of the best variant per (CPU model, shape class).
+ *
+ * A shape class is the operand width and the rounded up log2 of m, k and n. tune() runs every
+ * usable variant on a random problem of the class and keeps the fastest one that gives the
+ * reference result. k and n are capped at kTuneMaxDimension only, so B still overflows the
+ * caches as in the real product; m is cut so that m * k * n stays under kTuneMaxWork (the
+ * row blocks repeat the same traffic on B). The table is a text file with
+ * one "cpu model<TAB>shape class<TAB>variant" line per entry; entries of other CPU models are
+ * kept, so one file can serve a heterogeneous cluster.
+ */
+class KernelRegistry {
+public:
+    static constexpr int kTuneMaxDimension = 4096;
+    static constexpr long long kTuneMaxWork = 1LL << 30;
+
+    /**
+     * Lookups of select(): classes found in the table, classes answered with the nearest
+     * tuned class and classes with no tuned class of their width at all.
+     */
+    struct Lookups {
+        long long exact = 0;
+        long long nearest = 0;
+        long long misses = 0;
+    };
+
+    KernelRegistry();
+
+    void add(KernelVariant variant);
+    const std::vector<KernelVariant>& variants() const { return variants_; }
+    const KernelVariant* find(const std::string& name) const;
+
+    static std::string shapeClass(int m, int k, int n, QuantizedWidth width);
+
+    /**
+     * @return false if the file cannot be read (the table is then left empty).
+     */
+    bool load(const std::string& path);
+
+    /**
+     * Write the table (temporary file and rename). @return false on error.
+     */
+    bool save(const std::string& path) const;
+
+    /**
+     * The tuned variant for this product. If the class has no entry for this CPU it is tuned
+     * on the spot when tuneOnMiss is set; otherwise the entry of the nearest class of the same
+     * width (fewest log2 steps on m, k and n) is used, and nullptr is returned if there is none.
+     */
+    const KernelVariant* select(int m, int k, int n, QuantizedWidth width, Arena& workspace);
+
+    /**
+     * Benchmark the usable variants for the class of (m, k, n, width) and record the winner.
+     */
+    const KernelVariant& tune(int m, int k, int n, QuantizedWidth width, Arena& workspace);
+
+    bool hasEntry(int m, int k, int n, QuantizedWidth width) const;
+
+    const Lookups& lookups() const { return lookups_; }
+
+    void setTuneOnMiss(bool tuneOnMiss) { tuneOnMiss_ = tuneOnMiss; }
+    void setLog(std::ostream* log) { log_ = log; }
+    bool changed() const { return changed_; }
+    const std::string& cpuModel() const { return cpuModel_; }
+
+private:
+    const KernelVariant* nearest(int m, int k, int n, QuantizedWidth width) const;
+
+    std::vector<KernelVariant> variants_;
+    std::map<std::string, std::string> table_;  // "cpu model<TAB>shape class" -> variant name
+    std::string cpuModel_;
+    bool tuneOnMiss_ = true;
+    bool changed_ = false;
+    std::ostream* log_ = nullptr;
+    Lookups lookups_;
+};
+
+#endif // KERNEL_REGISTRY_H
@@ -0,0 +1,126 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include "arena.h"
+#include "matrix.h"
+#include <string>
+
+class KernelRegistry;
+
+/**
+ * Cache blocking parameters of multiplyBlocked.
+ * A kc x nc panel of B is packed once and reused by every row of A.
+ */
+struct BlockSizes {
+    int mc = 64;
+    int kc = 256;
+    int nc = 1024;
+    int mr = 1;  // rows of C updated together by the inner loop (1, 2 or 4)
+};
+
+/**
+ * C = A * B with cache blocking, threaded with OpenMP over a static split of the rows of C.
+ * Each thread zeroes and computes its own rows and packs its own copy of the B panels,
+ * so with pinned threads C and the panels are first touched on the right NUMA node.
+ * The panels are taken from `workspace` and given back before returning,
+ * so a warm workspace makes the call allocation free.
+ * C must be rows(A) x cols(B) and must not alias A or B.
+ */
+void multiplyBlocked(const Matrix& A, const Matrix& B, Matrix& C, Arena& workspace,
+                     const BlockSizes& blocks = BlockSizes());
+
+enum class Transpose {
+    No,
+    Yes,
+};
+
+/**
+ * BLAS-style C = alpha * op(A) * op(B) + beta * C, op(X) being X or X^T, updated in place
+ * with the blocking and threading of multiplyBlocked (which is the alpha = 1, beta = 0 case).
+ * beta = 0 never reads C (it may hold garbage, and its padding is zeroed), beta = 1 leaves it
+ * as it is before accumulating, so partial products can be summed into C, or into a view of
+ * it, without a temporary. op(A) is packed (transposed and scaled by alpha) block by block
+ * when transA is set or alpha != 1, op(B) is always packed. Arithmetic is modulo 2^32.
+ * C must be rows(op(A)) x cols(op(B)) and must not alias A or B.
+ */
+void gemm(Transpose transA, Transpose transB, int alpha, const Matrix& A, const Matrix& B,
+          int beta, Matrix& C, Arena& workspace, const BlockSizes& blocks = BlockSizes());
+
+/**
+ * One product alpha * op(A) * op(B) of a gemmFused sum (the handles are copied, not the elements).
+ */
+struct GemmTerm {
+    Transpose transA = Transpose::No;
+    Transpose transB = Transpose::No;
+    int alpha = 1;
+    Matrix A;
+    Matrix B;
+};
+
+/**
+ * Element-wise step applied to the finished tiles of C by gemmFused: `apply` gets the
+ * tile c[0:mc, 0:nc] (leading dimension ldc) whose top left element is C(i0, j0).
+ * An empty epilogue (apply == nullptr) leaves the tiles as they are.
+ */
+struct TileEpilogue {
+    void (*apply)(const void* context, int* c, std::size_t ldc, int i0, int j0, int mc, int nc) = nullptr;
+    const void* context = nullptr;
+};
+
+/**
+ * C = epilogue(sum over t of alpha_t * op(A_t) * op(B_t) + beta * C), gemm with several
+ * products accumulated into the same tiles of C and an element-wise epilogue run on each
+ * mc x nc tile right after its last update, while it is still in cache, so C is written
+ * once instead of once per product and once more per element-wise step.
+ * The products must all be rows(C) x cols(C); beta is applied before the products as in gemm.
+ * Used by the lazy expressions of expression.h; gemm is the one-term case without epilogue.
+ */
+void gemmFused(const GemmTerm* terms, int count, int beta, Matrix& C, Arena& workspace,
+               const BlockSizes& blocks = BlockSizes(), const TileEpilogue& epilogue = TileEpilogue());
+
+/**
+ * Reference C = A * B, i-k-j loop threaded over the rows of C, no blocking.
+ */
+void multiplyNaive(const Matrix& A, const Matrix& B, Matrix& C);
+
+/**
+ * C = A * B with Strassen's recursion (7 half-size products instead of 8) down to
+ * operands whose smallest dimension is <= `threshold`, then multiplyBlocked.
+ * The operands are zero padded to even splits; arithmetic is modulo 2^32 like the other
+ * kernels, so the result is exact whenever theirs is. Temporaries come from `workspace`.
+ */
+void multiplyStrassen(const Matrix& A, const Matrix& B, Matrix& C, Arena& workspace,
+                      int threshold = 128, const BlockSizes& blocks = BlockSizes());
+
+/**
+ * What multiplyAuto decided, for reporting.
+ */
+struct KernelReport {
+    const char* kernel = "";
+    std::string structureA;
+    std::string structureB;
+    double detectSeconds = 0;
+};
+
+/**
+ * C = A * B with the cheapest exact kernel. detectStructure (structure.h) classifies both
+ * operands; zero, identity, diagonal, banded, triangular and symmetric operands go to
+ * multiplyStructured, vector shapes (one row, one column or K = 1) to multiplyVectorShape
+ * (vector_kernels.h), the others to multiplyInt8 / multiplyInt16 (quantized.h) when every
+ * element fits, gemm with alpha = 1 and beta = 0 (reported as "blocked") otherwise. With a `registry` the general case goes instead
+ * to the variant tuned for the shape class (see kernel_registry.h).
+ * `rowOffsetA` is the global index of A's first row when A is a row block of a larger matrix.
+ */
+void multiplyAuto(const Matrix& A, const Matrix& B, Matrix& C, Arena& workspace,
+                  KernelReport* report = nullptr, int rowOffsetA = 0, KernelRegistry* registry = nullptr);
+
+/**
+ * C = A^k for a square A and k >= 0 (A^0 is the identity) with O(log k) calls to
+ * multiplyAuto: left-to-right binary exponentiation, one squaring per bit of k after the
+ * leading one and one multiplication by A per further set bit. The products alternate
+ * between C and a single temporary from `workspace`, ordered so that the last one is
+ * written to C. C must be A.rows x A.cols and must not alias A.
+ */
+void multiplyPower(const Matrix& A, int k, Matrix& C, Arena& workspace);
+
+#endif // KERNELS_H
@@ -0,0 +1,106 @@
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include "arena.h"
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/**
+ * Dense row-major int matrix whose storage is owned by an Arena.
+ * Rows are padded to `stride` elements so that every row starts on a 64-byte boundary.
+ * The struct itself is a cheap handle: copying it does not copy the elements.
+ * A handle can also be a view of a block of a larger matrix (see subMatrix): `stride` is
+ * then the parent's, and the ints past `cols` in each row belong to the parent, so kernels
+ * only write up to span().
+ */
+struct Matrix {
+    int rows = 0;
+    int cols = 0;
+    int stride = 0;
+    int* data = nullptr;
+    bool padded = true;  // false for views: [cols, stride) of every row is not ours
+
+    /**
+     * @return ints of each row that may be written: the padding included unless this is a view.
+     */
+    int span() const { return padded ? stride : cols; }
+
+    int* row(int i) { return data + static_cast<std::size_t>(i) * stride; }
+    const int* row(int i) const { return data + static_cast<std::size_t>(i) * stride; }
+    int& at(int i, int j) { return row(i)[j]; }
+    int at(int i, int j) const { return row(i)[j]; }
+
+    /**
+     * @return number of ints spanned by the storage, padding included (what MPI has to move).
+     */
+    std::size_t storageSize() const { return static_cast<std::size_t>(rows) * stride; }
+};
+
+/**
+ * @return smallest stride >= cols that keeps every row 64-byte aligned.
+ */
+int paddedStride(int cols);
+
+/**
+ * Allocate a rows x cols matrix in the arena. The elements are not initialised.
+ */
+Matrix allocateMatrix(Arena& arena, int rows, int cols);
+
+/**
+ * Set the span() of every row to `value` (a view's parent is left alone).
+ */
+void fillMatrix(Matrix& M, int value);
+
+/**
+ * Rows [begin, begin + count) of M, sharing M's storage.
+ */
+Matrix rowBlock(const Matrix& M, int begin, int count);
+
+/**
+ * O(1) view of the block M[row:row+rows, col:col+cols], sharing M's storage and stride.
+ * Every kernel accepts views as operands and as C; nothing past the block is read or written.
+ * A block of whole rows is a rowBlock and keeps M's padding.
+ */
+Matrix subMatrix(const Matrix& M, int row, int col, int rows, int cols);
+
+/**
+ * Balanced split of `count` items into `parts` contiguous ranges; range `part` is [begin, end).
+ * Used both for the rows owned by a rank and for the rows computed by a thread.
+ */
+void blockRange(int count, int parts, int part, int& begin, int& end);
+
+/**
+ * Guided self-scheduling split of `count` items for `parts` workers: each range takes
+ * 1/(2 * parts) of what is left, never less than `minSize` items, so the ranges shrink
+ * as the work drains. @return the boundaries: range t is [bounds[t], bounds[t + 1]).
+ */
+std::vector<int> guidedRanges(int count, int parts, int minSize);
+
+/**
+ * Raw binary layout: these 8 bytes, rows and cols as int32, then the rows * cols elements
+ * as int32 row after row (no padding), all in host byte order.
+ */
+constexpr char kBinaryMatrixMagic[9] = "MMBIN001";
+
+/**
+ * Read a matrix in the project text format (first line "rows cols", then the elements),
+ * or in the binary layout above when the file starts with kBinaryMatrixMagic.
+ * @return false if the file cannot be opened or is truncated.
+ */
+bool readMatrixFromFile(const std::string& filename, Arena& arena, Matrix& matrix);
+
+/**
+ * Print the matrix in the same layout used by main (elements separated by spaces, one row per line).
+ */
+void writeMatrix(std::ostream& out, const Matrix& M);
+
+/**
+ * Write the matrix in the binary layout, header included.
+ */
+void writeMatrixBinary(std::ostream& out, const Matrix& M);
+
+Matrix fromNested(Arena& arena, const std::vector<std::vector<int>>& nested);
+std::vector<std::vector<int>> toNested(const Matrix& M);
+
+#endif // MATRIX_H
@@ -0,0 +1,36 @@
+#ifndef MODULAR_H
+#define MODULAR_H
+
+#include "arena.h"
+#include "kernels.h"
+#include "matrix.h"
+#include <cstdint>
+
+/**
+ * Runtime prime (any modulus 2 <= p < 2^31 works) with its Barrett constant.
+ */
+struct Modulus {
+    std::uint32_t p = 0;
+    std::uint64_t barrett = 0;  // floor((2^64 - 1) / p)
+    int delay = 0;              // products of residues a reduced 64-bit accumulator can take without overflow
+
+    explicit Modulus(std::uint32_t p);
+
+    static bool valid(std::uint64_t p) { return p >= 2 && p < (std::uint64_t(1) << 31); }
+
+    std::uint32_t reduce(std::uint64_t x) const;
+    std::uint32_t reduce(int x) const;
+};
+
+/**
+ * C = A * B mod p, every element of C in [0, p). A and B may hold any int (negative
+ * values are taken modulo p too).
+ * Blocked like multiplyBlocked, with the packed panel of B reduced once. Products are
+ * accumulated in 64 bits and the accumulators are only reduced every `delay` terms,
+ * with a vectorised approximate Barrett step (32 x 32 -> 64 multiplies) and a few
+ * conditional subtractions, so there is no separate reduction pass over C.
+ */
+void multiplyModular(const Matrix& A, const Matrix& B, Matrix& C, const Modulus& modulus,
+                     Arena& workspace, const BlockSizes& blocks = BlockSizes());
+
+#endif // MODULAR_H
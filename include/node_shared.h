@@ -0,0 +1,44 @@
+#ifndef NODE_SHARED_H
+#define NODE_SHARED_H
+
+#include "matrix.h"
+#include <mpi/mpi.h>
+
+/**
+ * One copy of a matrix per node, in an MPI-3 shared memory window.
+ *
+ * The ranks of `comm` are grouped by node with MPI_Comm_split_type(MPI_COMM_TYPE_SHARED);
+ * the first rank of every node (the leader) allocates the window with MPI_Win_allocate_shared,
+ * the others map it with MPI_Win_shared_query and read the elements in place.
+ * Rank 0 of `comm` is always a leader.
+ * Construction and destruction are collective over `comm`.
+ */
+class NodeSharedMatrix {
+public:
+    NodeSharedMatrix(MPI_Comm comm, int rows, int cols);
+    ~NodeSharedMatrix();
+    NodeSharedMatrix(const NodeSharedMatrix&) = delete;
+    NodeSharedMatrix& operator=(const NodeSharedMatrix&) = delete;
+
+    /**
+     * Collective over `comm`: copy `source` (significant on rank 0 only) into the node copies.
+     * Rank 0 fills its node's copy, the leaders broadcast it among themselves and every rank
+     * waits until its node's copy is complete. With `interleave` the leaders spread the copy
+     * over the NUMA nodes first (see placement.h).
+     */
+    void broadcast(const Matrix& source, bool interleave);
+
+    const Matrix& matrix() const { return matrix_; }
+    bool leader() const { return nodeRank_ == 0; }
+    int nodeSize() const { return nodeSize_; }
+
+private:
+    MPI_Comm node_ = MPI_COMM_NULL;
+    MPI_Comm leaders_ = MPI_COMM_NULL;  // MPI_COMM_NULL on the other ranks
+    MPI_Win window_ = MPI_WIN_NULL;
+    int nodeRank_ = 0;
+    int nodeSize_ = 1;
+    Matrix matrix_;
+};
+
+#endif // NODE_SHARED_H
@@ -0,0 +1,80 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * Hardware events counted by PerfCounters.
+ */
+enum PerfEvent {
+    kCycles,
+    kInstructions,
+    kL1dMisses,
+    kLlcMisses,
+    kBranchMisses,
+    kPerfEventCount,
+};
+
+/**
+ * Counts of the events, summed over the threads of a rank. An event that could not be opened
+ * has valid[event] == false.
+ */
+struct CounterValues {
+    std::uint64_t count[kPerfEventCount] = {};
+    bool valid[kPerfEventCount] = {};
+
+    CounterValues operator-(const CounterValues& earlier) const;
+};
+
+/**
+ * Linux perf_event counters (user space only) for every OpenMP thread of the rank.
+ *
+ * The constructor opens, in a parallel region, one counter per event on each OpenMP thread,
+ * so it must run after the thread count and pinning are final (see placement.h). The counters
+ * run from then on; read() sums them over the threads (scaled if the kernel multiplexed them)
+ * and regions are recorded as differences of two reads.
+ * When perf_event_open is refused (no PMU in the VM, seccomp in the container,
+ * perf_event_paranoid) the object is simply unavailable: read() gives invalid values,
+ * add() does nothing and report() says why.
+ */
+class PerfCounters {
+public:
+    PerfCounters();
+    ~PerfCounters();
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const { return available_; }
+    const std::string& error() const { return error_; }
+
+    CounterValues read() const;
+
+    /**
+     * Accumulate `delta` under `region`; `flops` (0 if not meaningful) gives the per FLOP ratios.
+     */
+    void add(const std::string& region, const CounterValues& delta, double flops, double seconds);
+
+    /**
+     * One line per region: seconds, counts, IPC and L1D / LLC misses per FLOP.
+     */
+    void report(std::ostream& out, int rank) const;
+
+private:
+    struct Region {
+        CounterValues values;
+        double flops = 0;
+        double seconds = 0;
+        int calls = 0;
+    };
+
+    std::vector<int> fds_;  // thread * kPerfEventCount + event, -1 if not open
+    bool available_ = false;
+    std::string error_;
+    std::map<std::string, Region> regions_;
+};
+
+#endif // PERF_COUNTERS_H
@@ -0,0 +1,28 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "arena.h"
+#include "distributed.h"
+#include <mpi/mpi.h>
+#include <string>
+#include <vector>
+
+/**
+ * Run every job of a manifest as a three-stage pipeline:
+ * read/parse (rank 0, reader thread) -> distribute + multiply (all ranks, main thread)
+ * -> write (rank 0, writer thread). Stages are connected by bounded queues and at most
+ * `depth` jobs are in flight, each one owning an arena that the writer resets when done,
+ * so parsing job N+1 and printing job N-1 are hidden behind the multiply of job N.
+ *
+ * Manifest: one job per line, "A.txt B.txt [C.txt]"; blank lines and lines starting with
+ * '#' are skipped. Without C.txt the product is printed on stdout.
+ * Must be called by every rank of `comm` (only rank 0 reads the manifest).
+ * The reader and writer threads may run on any of `helperCpus`, normally the cpus of the rank
+ * (see pinHelperThread), so that they run beside the compute threads, not on thread 0's cpu.
+ * @return 0 if every job succeeded, 1 otherwise.
+ */
+int runManifest(const std::string& manifest, MPI_Comm comm, Arena& workspace,
+                const DistributedOptions& options, int depth,
+                const std::vector<int>& helperCpus = std::vector<int>());
+
+#endif // PIPELINE_H
@@ -0,0 +1,67 @@
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+
+#include "matrix.h"
+#include <mpi/mpi.h>
+#include <cstddef>
+#include <iosfwd>
+#include <thread>
+#include <vector>
+
+/**
+ * Where a rank and its threads run, as decided by pinRankAndThreads.
+ */
+struct Placement {
+    int localRank = 0;             // rank among the processes of the same node
+    int localSize = 1;
+    std::vector<int> cpus;         // cpus assigned to this rank
+    std::vector<int> threadCpus;   // cpu of every OpenMP thread, -1 if the thread is not pinned
+    std::vector<int> numaNodes;    // NUMA node of every entry of `cpus`
+    bool pinned = false;
+    bool numaPolicies = false;     // true if mbind is available to interleave shared operands
+};
+
+/**
+ * Split the cpus allowed to this node among the co-located ranks of `comm`
+ * (contiguous groups, so a rank does not straddle sockets when it can be avoided)
+ * and pin every OpenMP thread to one cpu of its rank's group.
+ * If OMP_NUM_THREADS is not set the thread count is set to the size of the group.
+ * With `pin` false nothing is changed and the current placement is only described.
+ */
+Placement pinRankAndThreads(MPI_Comm comm, bool pin);
+
+void reportPlacement(std::ostream& out, int rank, const Placement& placement);
+
+/**
+ * Let `thread` run on any cpu of `cpus`, normally Placement::cpus (the whole group of the rank).
+ * Helper threads (pipeline stages, checkpoint writer, progress thread) are started by the main
+ * thread, which pinRankAndThreads pins to the single cpu of OpenMP thread 0: left alone they
+ * would inherit that cpu and take their time from thread 0 instead of running beside it.
+ * @return false if `cpus` is empty or the affinity could not be set.
+ */
+bool pinHelperThread(std::thread& thread, const std::vector<int>& cpus);
+
+/**
+ * @return cpus `thread` may run on.
+ */
+std::vector<int> threadAffinity(std::thread& thread);
+
+/**
+ * @return NUMA node of `cpu` according to sysfs, 0 on machines without NUMA information.
+ */
+int numaNodeOfCpu(int cpu);
+
+/**
+ * Spread the pages of [data, data + bytes) round robin over all NUMA nodes.
+ * Used for operands read by every thread (B). Pages already touched are migrated.
+ * @return false if the kernel or the build does not support memory policies.
+ */
+bool interleaveMemory(void* data, std::size_t bytes);
+
+/**
+ * Write zeros to M with the same static row partition used by the threaded kernels,
+ * so each page is first touched, hence placed, by the thread that will compute on it.
+ */
+void firstTouchRows(Matrix& M);
+
+#endif // PLACEMENT_H
@@ -0,0 +1,89 @@
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+#include "spsc_queue.h"
+#include <mpi/mpi.h>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/**
+ * A point-to-point message handed to a ProgressThread. The buffer and the Transfer itself
+ * must stay valid, and untouched by the submitter, until isDone().
+ */
+struct Transfer {
+    enum class Kind {
+        Send,
+        Receive,
+    };
+
+    Kind kind = Kind::Send;
+    void* buffer = nullptr;
+    int count = 0;
+    MPI_Datatype type = MPI_DATATYPE_NULL;
+    int peer = 0;
+    int tag = 0;
+    MPI_Comm comm = MPI_COMM_NULL;
+    std::atomic<bool> done{false};
+
+    bool isDone() const { return done.load(std::memory_order_acquire); }
+};
+
+/**
+ * Thread that owns the point-to-point traffic of the distributed engines, so messages keep
+ * moving while the compute threads are inside a kernel and never call MPI (Open MPI only
+ * progresses non-blocking transfers from within MPI calls). The submitting thread hands it
+ * Transfers through a lock-free SpscQueue; it posts them with MPI_Isend / MPI_Irecv, polls
+ * them with MPI_Testsome and flags each one done as it completes. It yields while transfers
+ * are in flight and naps while it has nothing to do.
+ * Needs MPI initialised with MPI_THREAD_MULTIPLE (the submitting thread keeps calling MPI),
+ * and must be destroyed before MPI_Finalize.
+ */
+class ProgressThread {
+public:
+    /**
+     * The thread may run on any of `cpus` (see pinHelperThread): give it the cpus of the rank,
+     * not the one of OpenMP thread 0 that the creating thread is pinned to. Empty: inherited.
+     */
+    explicit ProgressThread(const std::vector<int>& cpus = std::vector<int>(), std::size_t capacity = 1024);
+
+    /**
+     * Completes every submitted transfer, then joins the thread.
+     */
+    ~ProgressThread();
+
+    ProgressThread(const ProgressThread&) = delete;
+    ProgressThread& operator=(const ProgressThread&) = delete;
+
+    /**
+     * Queue `transfer` to be posted by the progress thread; spins while the queue is full.
+     * Only one thread may submit.
+     */
+    void submit(Transfer& transfer);
+
+    /**
+     * Wait (yielding, without calling MPI) until the transfers are done.
+     */
+    static void wait(const Transfer& transfer);
+    static void waitAll(const Transfer* transfers, int count);
+
+    /**
+     * @return true if MPI was initialised with MPI_THREAD_MULTIPLE.
+     */
+    static bool supported();
+
+    /**
+     * @return cpus the progress thread may run on.
+     */
+    std::vector<int> cpus();
+
+private:
+    void run();
+
+    SpscQueue<Transfer*> queue_;
+    std::atomic<bool> stop_{false};
+    std::thread thread_;
+};
+
+#endif // PROGRESS_H
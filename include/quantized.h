@@ -0,0 +1,46 @@
+#ifndef QUANTIZED_H
+#define QUANTIZED_H
+
+#include "arena.h"
+#include "kernels.h"
+#include "matrix.h"
+
+struct ValueRange {
+    int min;
+    int max;
+};
+
+/**
+ * Narrowest element type able to hold both operands exactly.
+ */
+enum class QuantizedWidth {
+    Int8,
+    Int16,
+    Int32,
+};
+
+/**
+ * Smallest and largest element of M (threaded, padding excluded). An empty matrix gives {0, 0}.
+ */
+ValueRange scanRange(const Matrix& M);
+
+QuantizedWidth quantizedWidth(ValueRange a, ValueRange b);
+
+/**
+ * C = A * B with both operands stored in 16 bits and products accumulated in 32 bits
+ * (pmaddwd: two widening multiply-adds per 32-bit lane). Every element of A and B must fit in int16.
+ * Uses AVX-512BW or AVX2 when the CPU has them, a portable loop otherwise.
+ */
+void multiplyInt16(const Matrix& A, const Matrix& B, Matrix& C, Arena& workspace,
+                   const BlockSizes& blocks = BlockSizes());
+
+/**
+ * C = A * B with both operands stored in 8 bits and products accumulated in 32 bits.
+ * With AVX-512 VNNI, A is biased to unsigned (a + 128) so that vpdpbusd can do four
+ * u8 x s8 multiply-adds per lane, and 128 * column sums of B are subtracted afterwards.
+ * Without VNNI it falls back to multiplyInt16. Every element of A and B must fit in int8.
+ */
+void multiplyInt8(const Matrix& A, const Matrix& B, Matrix& C, Arena& workspace,
+                  const BlockSizes& blocks = BlockSizes());
+
+#endif // QUANTIZED_H
@@ -0,0 +1,25 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+
+/**
+ * Counter-based random numbers: the value is a pure function of (seed, counter), so any
+ * thread or rank can produce any part of a random sequence without sharing a generator state.
+ * The mixing function is the SplitMix64 finalizer applied to seed-keyed counters.
+ */
+inline std::uint64_t counterRandom(std::uint64_t seed, std::uint64_t counter) {
+    std::uint64_t z = seed + (counter + 1) * 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * Seed of an independent stream derived from `seed`, e.g. one per round or per row.
+ */
+inline std::uint64_t streamSeed(std::uint64_t seed, std::uint64_t stream) {
+    return counterRandom(seed ^ 0x6a09e667f3bcc909ULL, stream);
+}
+
+#endif // RANDOM_H
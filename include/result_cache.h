@@ -0,0 +1,81 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include "matrix.h"
+#include "semiring.h"
+#include <cstdint>
+#include <fstream>
+#include <iosfwd>
+#include <string>
+
+/**
+ * 128-bit content address of a product: two XXH64 (different seeds) over the
+ * dimensions and the elements of both operands (padding excluded).
+ */
+struct CacheKey {
+    std::uint64_t high = 0;
+    std::uint64_t low = 0;
+
+    std::string hex() const;
+};
+
+/**
+ * Key of A * B, or of A * B mod `modulus` when it is not 0 (see modular.h),
+ * over `semiring` when it is not the ordinary one (see semiring.h).
+ */
+CacheKey operandKey(const Matrix& A, const Matrix& B, std::uint32_t modulus = 0,
+                    SemiringKind semiring = SemiringKind::PlusTimes);
+
+/**
+ * A cache entry opened for reading. The file stays readable even if another job
+ * evicts it meanwhile (the descriptor keeps the inode alive).
+ */
+struct CachedResult {
+    int rows = 0;
+    int cols = 0;
+    std::ifstream in;
+
+    /**
+     * Copy the cached C to `out` in the same layout as writeMatrix, one row at a time.
+     * @return false if the entry turns out to be truncated.
+     */
+    bool stream(std::ostream& out);
+};
+
+/**
+ * On-disk cache of products, shareable by several jobs on the same (shared) filesystem.
+ *
+ * Protocol:
+ * - an entry is written to a private temporary file and published with rename(),
+ *   so readers never see a partial entry and concurrent writers of the same key are harmless;
+ * - a hit refreshes the entry's mtime, which is the recency used by the LRU;
+ * - eviction runs under an fcntl lock on <directory>/.lock (works over NFS with lockd)
+ *   and removes the least recently used entries until the total is below maxBytes.
+ */
+class ResultCache {
+public:
+    struct Stats {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t stores = 0;
+        std::uint64_t evictions = 0;
+    };
+
+    ResultCache(std::string directory, std::uint64_t maxBytes);
+
+    bool open(const CacheKey& key, CachedResult& result);
+    bool store(const CacheKey& key, const Matrix& C);
+    void evict();
+
+    const Stats& stats() const { return stats_; }
+    const std::string& directory() const { return directory_; }
+
+private:
+    std::string entryPath(const CacheKey& key) const;
+
+    std::string directory_;
+    std::uint64_t maxBytes_;
+    Stats stats_;
+};
+
+#endif // RESULT_CACHE_H
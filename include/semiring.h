@@ -0,0 +1,97 @@
+#ifndef SEMIRING_H
+#define SEMIRING_H
+
+#include "arena.h"
+#include "kernels.h"
+#include "matrix.h"
+#include <climits>
+
+/**
+ * Semirings over int for multiplySemiring: C(i, j) = add over k of mul(A(i, k), B(k, j)).
+ * `zero` is the identity of add and absorbs mul, `one` is the identity of mul.
+ * The tropical semirings use INT_MAX / INT_MIN as +/- infinity (also in matrix files);
+ * finite sums are not saturated, so finite entries must stay within +/- 2^30.
+ */
+struct PlusTimes {
+    static constexpr const char* name = "plus-times";
+    static constexpr int zero() { return 0; }
+    static constexpr int one() { return 1; }
+    static constexpr int add(int a, int b) { return static_cast<int>(static_cast<unsigned>(a) + static_cast<unsigned>(b)); }
+    static constexpr int mul(int a, int b) { return static_cast<int>(static_cast<unsigned>(a) * static_cast<unsigned>(b)); }
+};
+
+/**
+ * Shortest paths: add = min, mul = +, zero = +infinity.
+ */
+struct MinPlus {
+    static constexpr const char* name = "min-plus";
+    static constexpr int zero() { return INT_MAX; }
+    static constexpr int one() { return 0; }
+    static constexpr int add(int a, int b) { return a < b ? a : b; }
+    static constexpr int mul(int a, int b) { return a == zero() || b == zero() ? zero() : a + b; }
+};
+
+/**
+ * Longest / critical paths: add = max, mul = +, zero = -infinity.
+ */
+struct MaxPlus {
+    static constexpr const char* name = "max-plus";
+    static constexpr int zero() { return INT_MIN; }
+    static constexpr int one() { return 0; }
+    static constexpr int add(int a, int b) { return a > b ? a : b; }
+    static constexpr int mul(int a, int b) { return a == zero() || b == zero() ? zero() : a + b; }
+};
+
+/**
+ * Bottleneck (widest) paths: add = max, mul = min.
+ */
+struct MaxMin {
+    static constexpr const char* name = "max-min";
+    static constexpr int zero() { return INT_MIN; }
+    static constexpr int one() { return INT_MAX; }
+    static constexpr int add(int a, int b) { return a > b ? a : b; }
+    static constexpr int mul(int a, int b) { return a < b ? a : b; }
+};
+
+/**
+ * C = A * B over the semiring S, blocked and threaded like multiplyBlocked (static row
+ * split, per-thread packed panels of B taken from `workspace`). Terms whose A element is
+ * S::zero() are skipped; the update of a row of C has an AVX-512 or AVX2 version for every
+ * semiring above (e.g. vpaddd + vpminsd for min-plus), chosen at run time.
+ * Instantiated for the four semirings above. C must not alias A or B.
+ */
+template <typename S>
+void multiplySemiring(const Matrix& A, const Matrix& B, Matrix& C, Arena& workspace,
+                      const BlockSizes& blocks = BlockSizes());
+
+/**
+ * Runtime choice of semiring, for main and the distributed engines.
+ */
+enum class SemiringKind {
+    PlusTimes,
+    MinPlus,
+    MaxPlus,
+    MaxMin,
+};
+
+/**
+ * @return false if `name` is none of "plus-times", "min-plus", "max-plus", "max-min".
+ */
+bool parseSemiringKind(const char* name, SemiringKind& kind);
+
+const char* semiringName(SemiringKind kind);
+
+/**
+ * S::zero() of the semiring `kind`.
+ */
+int semiringZero(SemiringKind kind);
+
+/**
+ * S::one() of the semiring `kind`.
+ */
+int semiringOne(SemiringKind kind);
+
+void multiplySemiring(SemiringKind kind, const Matrix& A, const Matrix& B, Matrix& C, Arena& workspace,
+                      const BlockSizes& blocks = BlockSizes());
+
+#endif // SEMIRING_H
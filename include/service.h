@@ -0,0 +1,21 @@
+#ifndef SERVICE_H
+#define SERVICE_H
+
+#include "arena.h"
+#include "distributed.h"
+#include <mpi/mpi.h>
+#include <string>
+
+/**
+ * Persistent service mode: the MPI job stays up and rank 0 accepts multiply requests
+ * on the Unix domain socket `socketPath` (see service_protocol.h), one connection per job.
+ * Every job is distributed to the warm ranks with distributedMultiply; the arenas are
+ * reset, not freed, between jobs and the OpenMP thread pools stay alive.
+ * A Shutdown request stops every rank.
+ * Must be called by every rank of `comm`.
+ * @return 0 on a clean shutdown, 1 if the socket cannot be opened.
+ */
+int runService(const std::string& socketPath, MPI_Comm comm,
+               Arena& storage, Arena& workspace, const DistributedOptions& options);
+
+#endif // SERVICE_H
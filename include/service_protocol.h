@@ -0,0 +1,73 @@
+#ifndef SERVICE_PROTOCOL_H
+#define SERVICE_PROTOCOL_H
+
+#include "arena.h"
+#include "matrix.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Wire format spoken over the Unix domain socket of the service mode (native byte order,
+ * client and server run on the same node).
+ *
+ * request:  magic, type, then
+ *           Paths:  string A, string B      (files read by the server)
+ *           Inline: matrix A, matrix B
+ * response: status, then matrix C (status Ok) or string message (status Error)
+ * string:   uint32 length, bytes
+ * matrix:   int32 rows, int32 cols, rows * cols int32 (no padding)
+ */
+constexpr std::uint32_t kRequestMagic = 0x4d4d5251; // "MMRQ"
+
+// largest matrix a request may carry or produce, padded rows included (1 GiB of int32)
+constexpr std::size_t kMaxMatrixElements = std::size_t(1) << 28;
+
+enum class RequestType : std::uint32_t {
+    Paths = 1,
+    Inline = 2,
+    Shutdown = 3,
+};
+
+enum class ResponseStatus : std::uint32_t {
+    Ok = 0,
+    Error = 1,
+};
+
+bool writeAll(int fd, const void* data, std::size_t bytes);
+bool readAll(int fd, void* data, std::size_t bytes);
+
+bool sendU32(int fd, std::uint32_t value);
+bool recvU32(int fd, std::uint32_t& value);
+bool sendString(int fd, const std::string& s);
+bool recvString(int fd, std::string& s, std::size_t maxLength = 4096);
+bool sendMatrix(int fd, const Matrix& M);
+
+/**
+ * @return false without allocating if the announced shape is negative or would take more
+ *         than maxElements ints once its rows are padded.
+ */
+bool recvMatrix(int fd, Arena& arena, Matrix& M, std::size_t maxElements = kMaxMatrixElements);
+
+/**
+ * @return true if a rows x cols matrix with padded rows holds at most maxElements ints
+ *         (checked without overflow for any int64 shape).
+ */
+bool matrixFits(std::int64_t rows, std::int64_t cols, std::size_t maxElements = kMaxMatrixElements);
+
+/**
+ * Reads and writes on `fd` fail after `milliseconds` without progress instead of blocking.
+ */
+bool setSocketTimeout(int fd, int milliseconds);
+
+/**
+ * @return listening socket bound to `path` (a stale socket file is replaced), -1 on error.
+ */
+int listenOnSocket(const std::string& path);
+
+/**
+ * @return socket connected to the service listening on `path`, -1 on error.
+ */
+int connectToSocket(const std::string& path);
+
+#endif // SERVICE_PROTOCOL_H
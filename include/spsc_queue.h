@@ -0,0 +1,64 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+/**
+ * Lock-free FIFO between exactly one producer thread and one consumer thread, on a ring
+ * of fixed capacity (rounded up to a power of two). Neither side ever blocks: tryPush fails
+ * when the ring is full, tryPop when it is empty. The two indices live on separate cache
+ * lines, each written by one side only, so the threads do not bounce a shared line per item.
+ */
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(std::size_t capacity) {
+        std::size_t slots = 1;
+        while (slots < capacity) {
+            slots *= 2;
+        }
+        slots_.reset(new T[slots]);
+        mask_ = slots - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    /**
+     * Producer side. @return false (and `value` is not queued) if the ring is full.
+     */
+    bool tryPush(const T& value) {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) > mask_) {
+            return false;
+        }
+        slots_[tail & mask_] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Consumer side. @return false if the ring is empty.
+     */
+    bool tryPop(T& value) {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = slots_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::size_t capacity() const { return mask_ + 1; }
+
+private:
+    std::unique_ptr<T[]> slots_;
+    std::size_t mask_ = 0;
+    alignas(64) std::atomic<std::size_t> head_{0};  // next slot to pop, written by the consumer
+    alignas(64) std::atomic<std::size_t> tail_{0};  // next slot to push, written by the producer
+};
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,55 @@
+#ifndef STRUCTURE_H
+#define STRUCTURE_H
+
+#include "matrix.h"
+#include "quantized.h"
+#include <string>
+
+enum StructureFlag : unsigned {
+    kZero = 1u << 0,
+    kIdentity = 1u << 1,
+    kDiagonal = 1u << 2,
+    kLowerTriangular = 1u << 3,
+    kUpperTriangular = 1u << 4,
+    kSymmetric = 1u << 5,
+};
+
+/**
+ * What detectStructure found out about a matrix. Element (i, j) is considered to be at
+ * global position (i + rowOffset, j), so that the row block of A owned by a rank is
+ * classified as part of the whole matrix (e.g. a block of rows of the identity is "identity").
+ */
+struct MatrixStructure {
+    unsigned flags = 0;
+    int rowOffset = 0;
+    int lowerBandwidth = 0;   // max(i - j) over the nonzeros (global i)
+    int upperBandwidth = 0;   // max(j - i) over the nonzeros (global i)
+    ValueRange range = {0, 0};
+    double seconds = 0;       // time spent detecting
+
+    bool is(StructureFlag flag) const { return (flags & flag) != 0; }
+};
+
+/**
+ * One threaded pass over M for the band, the value range and identity, plus an early-exit
+ * pass for symmetry on square matrices: O(rows * cols), negligible next to the product.
+ */
+MatrixStructure detectStructure(const Matrix& M, int rowOffset = 0);
+
+/**
+ * @return e.g. "identity", "diagonal", "lower-triangular", "banded(l=1,u=2)", "symmetric", "dense".
+ */
+std::string describeStructure(const MatrixStructure& s, int cols);
+
+/**
+ * C = A * B exploiting the structure of the operands:
+ * zero operands fill C, identity operands copy, diagonal operands scale rows or columns,
+ * banded and triangular operands skip the known-zero part of the k and j ranges, and
+ * A * A with A symmetric computes one triangle of C and mirrors it.
+ * `sa` and `sb` come from detectStructure (sa.rowOffset locates A's rows in the whole matrix).
+ * @return the name of the kernel used, nullptr if no structure is worth exploiting (C untouched).
+ */
+const char* multiplyStructured(const Matrix& A, const Matrix& B, Matrix& C,
+                               const MatrixStructure& sa, const MatrixStructure& sb);
+
+#endif // STRUCTURE_H
@@ -0,0 +1,17 @@
+#ifndef VECTOR_KERNELS_H
+#define VECTOR_KERNELS_H
+
+#include "arena.h"
+#include "matrix.h"
+
+/**
+ * Memory-bound shapes that the blocked kernels handle badly:
+ *   dot    1 x K * K x 1   threaded reduction
+ *   gemv   M x K * K x 1   one dot product per row of A, rows split among threads
+ *   gevm   1 x K * K x N   axpy of the rows of B, columns of C split among threads
+ *   outer  M x 1 * 1 x N   rank-1 update, rows split among threads
+ * @return the name of the kernel used, nullptr if the shape is none of the above (C untouched).
+ */
+const char* multiplyVectorShape(const Matrix& A, const Matrix& B, Matrix& C, Arena& workspace);
+
+#endif // VECTOR_KERNELS_H
@@ -0,0 +1,30 @@
+#ifndef VERIFY_H
+#define VERIFY_H
+
+#include "arena.h"
+#include "matrix.h"
+#include <mpi/mpi.h>
+#include <cstdint>
+
+/**
+ * Freivalds' check of C == A * B in O(n^2) per round: for a random vector r it compares
+ * A (B r) with C r. Arithmetic is modulo 2^32, like the int kernels, so wrapped products
+ * verify; a wrong C passes one round with probability at most 1/2, all of them with
+ * probability at most 2^-rounds. The vectors depend only on `seed` (see random.h).
+ * Matrix-vector products are threaded over rows; the scratch vectors come from `workspace`.
+ * @return true if every round agrees (always true for rounds <= 0).
+ */
+bool freivalds(const Matrix& A, const Matrix& B, const Matrix& C, Arena& workspace,
+               int rounds, std::uint64_t seed = 1);
+
+/**
+ * Distributed Freivalds' check; A, B and C are significant on rank 0 only.
+ * The rows of A and C and the rows of B are scattered in balanced blocks, every rank
+ * computes its block of B r, the blocks are allgathered, then every rank checks its rows
+ * of A (B r) against C r and the verdicts are combined with an Allreduce.
+ * @return the verdict, on every rank.
+ */
+bool distributedFreivalds(const Matrix& A, const Matrix& B, const Matrix& C, MPI_Comm comm,
+                          Arena& storage, Arena& workspace, int rounds, std::uint64_t seed = 1);
+
+#endif // VERIFY_H
@@ -0,0 +1,142 @@
+#!/bin/bash
+
+# Local strong and weak scaling study of main.
+#
+# For every rank count in 1..RANKS and thread count in 1..THREADS (powers of two, plus the
+# maxima themselves) main is run under mpirun with --timings and the fastest of REPEATS runs
+# is kept. The time that scales is the multiplication (distribute + compute + collect);
+# reading and printing the matrices are reported but left out of speedup and efficiency.
+#
+#   strong: A and B are SIZE x SIZE for every run,   efficiency = T(1,1) / (p * t * T(p,t))
+#   weak:   A is (SIZE * p * t) x SIZE, B SIZE x SIZE, efficiency = T(1,1) / T(p,t)
+#
+# With -e the script exits with status 1 if some efficiency is below the threshold.
+
+usage() {
+    echo "usage: $0 [-b BUILD_DIR] [-n SIZE] [-r RANKS] [-t THREADS] [-k REPEATS] [-m MAX_VALUE] [-e MIN_EFFICIENCY] [-s strong|weak|both]" >&2
+    exit 2
+}
+
+BUILD_DIR=build
+SIZE=512
+RANKS=$(nproc)
+THREADS=1
+REPEATS=3
+MAX_VALUE=1000
+MIN_EFFICIENCY=
+STUDY=both
+
+while getopts "b:n:r:t:k:m:e:s:h" option; do
+    case $option in
+        b) BUILD_DIR=$OPTARG ;;
+        n) SIZE=$OPTARG ;;
+        r) RANKS=$OPTARG ;;
+        t) THREADS=$OPTARG ;;
+        k) REPEATS=$OPTARG ;;
+        m) MAX_VALUE=$OPTARG ;;
+        e) MIN_EFFICIENCY=$OPTARG ;;
+        s) STUDY=$OPTARG ;;
+        *) usage ;;
+    esac
+done
+
+MAIN=$(realpath "$BUILD_DIR/main" 2>/dev/null)
+MATGEN=$(realpath "$BUILD_DIR/matgen" 2>/dev/null)
+if [ ! -x "$MAIN" ] || [ ! -x "$MATGEN" ]; then
+    echo "main or matgen not found in $BUILD_DIR, run ./build.sh first" >&2
+    exit 2
+fi
+
+MPIRUN_FLAGS="--oversubscribe"
+if [ "$(id -u)" = 0 ]; then
+    MPIRUN_FLAGS="$MPIRUN_FLAGS --allow-run-as-root"
+fi
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# 1, 2, 4, ... up to and including the maximum
+counts() {
+    local c=1
+    while [ "$c" -lt "$1" ]; do
+        echo "$c"
+        c=$((c * 2))
+    done
+    echo "$1"
+}
+
+# generate ROWS COLS SEED FILE: uniform integers in [-MAX_VALUE, MAX_VALUE]
+generate() {
+    "$MATGEN" "$1" "$2" --seed "$3" --min "-$MAX_VALUE" --max "$MAX_VALUE" --output "$4"
+}
+
+# run RANKS THREADS: prints "read distribute compute collect write multiply" of the fastest run
+run() {
+    local best=
+    for ((repeat = 0; repeat < REPEATS; ++repeat)); do
+        local line
+        line=$(cd "$WORK" && OMP_NUM_THREADS=$2 mpirun $MPIRUN_FLAGS -np "$1" "$MAIN" --timings 2>&1 >/dev/null | grep '^\[timings\]')
+        if [ -z "$line" ]; then
+            echo "main failed with $1 ranks and $2 threads" >&2
+            exit 1
+        fi
+        line=$(echo "$line" | awk '{
+            for (i = 2; i <= NF; ++i) { split($i, kv, "="); t[kv[1]] = kv[2] }
+            printf "%s %s %s %s %s %.6f\n", t["read"], t["distribute"], t["compute"], t["collect"], t["write"],
+                   t["distribute"] + t["compute"] + t["collect"]
+        }')
+        if [ -z "$best" ] || awk -v a="${line##* }" -v b="${best##* }" 'BEGIN { exit !(a < b) }'; then
+            best=$line
+        fi
+    done
+    echo "$best"
+}
+
+FAILED=0
+
+# study NAME: one table, rows of A scaled by p * t for the weak study
+study() {
+    echo
+    echo "$1 scaling, B ${SIZE}x${SIZE}, fastest of $REPEATS runs, times in seconds"
+    printf "%6s %8s %8s %10s %10s %10s %10s %10s %10s %8s %10s\n" \
+        ranks threads rowsA read distribute compute collect write multiply speedup efficiency
+    local reference=
+    for p in $(counts "$RANKS"); do
+        for t in $(counts "$THREADS"); do
+            local rows=$SIZE
+            if [ "$1" = weak ]; then
+                rows=$((SIZE * p * t))
+            fi
+            generate "$rows" "$SIZE" 1 "$WORK/matrixA.txt"
+            generate "$SIZE" "$SIZE" 2 "$WORK/matrixB.txt"
+            local times
+            times=$(run "$p" "$t") || exit 1
+            local multiply=${times##* }
+            if [ -z "$reference" ]; then
+                reference=$multiply
+            fi
+            local row
+            row=$(awk -v study="$1" -v ref="$reference" -v m="$multiply" -v p="$p" -v t="$t" 'BEGIN {
+                speedup = study == "weak" ? ref * p * t / m : ref / m
+                printf "%.2f %.2f\n", speedup, speedup / (p * t)
+            }')
+            printf "%6d %8d %8d %10.4f %10.4f %10.4f %10.4f %10.4f %10.4f %8s %10s\n" \
+                "$p" "$t" "$rows" $times $row
+            if [ -n "$MIN_EFFICIENCY" ] && awk -v e="${row##* }" -v min="$MIN_EFFICIENCY" 'BEGIN { exit !(e < min) }'; then
+                FAILED=1
+            fi
+        done
+    done
+}
+
+case $STUDY in
+    strong) study strong ;;
+    weak) study weak ;;
+    both) study strong && study weak ;;
+    *) usage ;;
+esac
+
+if [ "$FAILED" = 1 ]; then
+    echo "efficiency below $MIN_EFFICIENCY" >&2
+    exit 1
+fi
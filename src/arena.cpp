@@ -0,0 +1,143 @@
+#include "arena.h"
+#include <cstdlib>
+#include <new>
+#include <sys/mman.h>
+
+namespace {
+
+constexpr std::size_t kHugePageBytes = std::size_t(2) << 20;
+
+std::size_t roundUp(std::size_t value, std::size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+}
+
+Arena::Arena(std::size_t chunkBytes, bool hugePages)
+    : chunkBytes_(roundUp(chunkBytes == 0 ? kDefaultChunkBytes : chunkBytes, kAlignment)),
+      hugePages_(hugePages) {}
+
+Arena::~Arena() {
+    release();
+}
+
+Arena::Chunk Arena::newChunk(std::size_t bytes) {
+    Chunk chunk{nullptr, 0, 0, false};
+    if (hugePages_) {
+        // explicit huge pages first (needs a reserved pool), then THP via madvise
+        chunk.size = roundUp(bytes, kHugePageBytes);
+        void* p = mmap(nullptr, chunk.size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p == MAP_FAILED) {
+            p = mmap(nullptr, chunk.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+            if (p != MAP_FAILED) {
+                madvise(p, chunk.size, MADV_HUGEPAGE);
+            }
+#endif
+        }
+        if (p != MAP_FAILED) {
+            chunk.data = static_cast<char*>(p);
+            chunk.mapped = true;
+        }
+    }
+    if (chunk.data == nullptr) {
+        chunk.size = roundUp(bytes, kAlignment);
+        void* p = nullptr;
+        if (posix_memalign(&p, kAlignment, chunk.size) != 0) {
+            throw std::bad_alloc();
+        }
+        chunk.data = static_cast<char*>(p);
+        chunk.mapped = false;
+    }
+    ++stats_.systemAllocations;
+    stats_.bytesReserved += chunk.size;
+    return chunk;
+}
+
+void Arena::freeChunk(Chunk& chunk) {
+    if (chunk.mapped) {
+        munmap(chunk.data, chunk.size);
+    } else {
+        std::free(chunk.data);
+    }
+    ++stats_.systemFrees;
+    stats_.bytesReserved -= chunk.size;
+    chunk.data = nullptr;
+}
+
+void* Arena::allocate(std::size_t bytes) {
+    ++stats_.allocations;
+    stats_.bytesRequested += bytes;
+    bytes = roundUp(bytes == 0 ? 1 : bytes, kAlignment);
+
+    // chunks after current_ are empty (rewind/reset zero them), reuse the first one that fits
+    while (current_ < chunks_.size() && chunks_[current_].size - chunks_[current_].used < bytes) {
+        ++current_;
+    }
+    if (current_ == chunks_.size()) {
+        chunks_.push_back(newChunk(bytes > chunkBytes_ ? bytes : chunkBytes_));
+    }
+
+    Chunk& chunk = chunks_[current_];
+    void* p = chunk.data + chunk.used;
+    chunk.used += bytes;
+
+    std::size_t inUse = bytesInUse();
+    if (inUse > stats_.highWater) {
+        stats_.highWater = inUse;
+    }
+    return p;
+}
+
+Arena::Mark Arena::mark() const {
+    if (chunks_.empty()) {
+        return {0, 0};
+    }
+    return {current_, chunks_[current_].used};
+}
+
+void Arena::rewind(const Mark& mark) {
+    if (chunks_.empty()) {
+        return;
+    }
+    for (std::size_t i = mark.chunk + 1; i < chunks_.size(); ++i) {
+        chunks_[i].used = 0;
+    }
+    chunks_[mark.chunk].used = mark.offset;
+    current_ = mark.chunk;
+}
+
+void Arena::reset() {
+    ++stats_.resets;
+    if (chunks_.size() > 1) {
+        // the last job did not fit in one chunk: replace them with one big enough for all of it
+        std::size_t total = 0;
+        for (Chunk& chunk : chunks_) {
+            total += chunk.size;
+            freeChunk(chunk);
+        }
+        chunks_.clear();
+        chunks_.push_back(newChunk(total));
+    }
+    for (Chunk& chunk : chunks_) {
+        chunk.used = 0;
+    }
+    current_ = 0;
+}
+
+void Arena::release() {
+    for (Chunk& chunk : chunks_) {
+        freeChunk(chunk);
+    }
+    chunks_.clear();
+    current_ = 0;
+}
+
+std::size_t Arena::bytesInUse() const {
+    std::size_t inUse = 0;
+    for (const Chunk& chunk : chunks_) {
+        inUse += chunk.used;
+    }
+    return inUse;
+}
@@ -0,0 +1,115 @@
+#include "arena.h"
+#include "generator.h"
+#include "kernels.h"
+#include "matrix.h"
+#include "quantized.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+
+/**
+ * Benchmark of the banded kernel against the dense kernel it replaces.
+ *
+ *   bench_structure [--size N] [--repeats R]
+ *
+ * For triangles and bands of A and of B, with int8 and int32 values, multiplyAuto is timed
+ * next to the dense kernel of the operand width (multiplyInt8 or multiplyBlocked), best of R
+ * runs. The exit status is 1 if multiplyAuto chose the banded kernel for a product that the
+ * dense kernel does faster, i.e. if the thresholds of structure.cpp need another look.
+ */
+namespace {
+
+int usage() {
+    std::cerr << "usage: bench_structure [--size N] [--repeats R]" << std::endl;
+    return 2;
+}
+
+struct BenchCase {
+    const char* name;
+    MatrixKind kindA;
+    int lowerA, upperA;
+    MatrixKind kindB;
+    int lowerB, upperB;
+};
+
+Matrix generate(Arena& arena, int n, MatrixKind kind, int lower, int upper, int maxValue, std::uint64_t seed) {
+    GeneratorSpec spec;
+    spec.kind = kind;
+    spec.rows = n;
+    spec.cols = n;
+    spec.seed = seed;
+    spec.minValue = -maxValue;
+    spec.maxValue = maxValue;
+    spec.lowerBandwidth = lower;
+    spec.upperBandwidth = upper;
+    Matrix M = allocateMatrix(arena, n, n);
+    generateRows(spec, 0, M);
+    return M;
+}
+
+double bestOf(int repeats, const std::function<void()>& run) {
+    double best = 0;
+    for (int repeat = 0; repeat < repeats; ++repeat) {
+        const auto start = std::chrono::steady_clock::now();
+        run();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = repeat == 0 ? seconds : std::min(best, seconds);
+    }
+    return best;
+}
+
+}
+
+int main(int argc, char** argv) {
+    int n = 1024;
+    int repeats = 3;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            n = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--repeats") == 0 && i + 1 < argc) {
+            repeats = std::atoi(argv[++i]);
+        } else {
+            return usage();
+        }
+    }
+    if (n <= 0 || repeats <= 0) {
+        return usage();
+    }
+
+    const BenchCase cases[] = {
+        {"lower triangle * dense", MatrixKind::LowerTriangular, 0, 0, MatrixKind::Random, 0, 0},
+        {"band(8,8) * dense", MatrixKind::Banded, 8, 8, MatrixKind::Random, 0, 0},
+        {"band(n/8,n/8) * dense", MatrixKind::Banded, n / 8, n / 8, MatrixKind::Random, 0, 0},
+        {"dense * band(2,40)", MatrixKind::Random, 0, 0, MatrixKind::Banded, 2, 40},
+        {"dense * upper triangle", MatrixKind::Random, 0, 0, MatrixKind::UpperTriangular, 0, 0},
+    };
+    Arena storage, workspace;
+    Matrix C = allocateMatrix(storage, n, n);
+    int slower = 0;
+    for (int maxValue : {100, 1000000}) {
+        for (const BenchCase& c : cases) {
+            Arena::Scope operands(storage);
+            const Matrix A = generate(storage, n, c.kindA, c.lowerA, c.upperA, maxValue, 1);
+            const Matrix B = generate(storage, n, c.kindB, c.lowerB, c.upperB, maxValue, 2);
+            const QuantizedWidth width = quantizedWidth(scanRange(A), scanRange(B));
+            KernelReport report;
+            const double chosen = bestOf(repeats, [&] { multiplyAuto(A, B, C, workspace, &report); });
+            const double dense = bestOf(repeats, [&] {
+                if (width == QuantizedWidth::Int32) {
+                    multiplyBlocked(A, B, C, workspace);
+                } else {
+                    multiplyInt8(A, B, C, workspace);
+                }
+            });
+            const bool bandedSlower = std::strcmp(report.kernel, "banded") == 0 && chosen > dense;
+            slower += bandedSlower ? 1 : 0;
+            std::cout << c.name << " (" << (width == QuantizedWidth::Int32 ? "int32" : "int8") << "): "
+                      << report.kernel << " " << chosen << " s, dense " << dense << " s"
+                      << (bandedSlower ? "  SLOWER" : "") << std::endl;
+        }
+    }
+    return slower > 0 ? 1 : 0;
+}
@@ -0,0 +1,365 @@
+#include "boolean.h"
+#include <immintrin.h>
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <ostream>
+#include <string>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+
+bool hasAvx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+bool hasAvx512() {
+    static const bool supported = __builtin_cpu_supports("avx512f");
+    return supported;
+}
+
+bool hasAvx512Popcount() {
+    static const bool supported = hasAvx512() && __builtin_cpu_supports("avx512vpopcntdq");
+    return supported;
+}
+
+bool hasPopcount() {
+    static const bool supported = __builtin_cpu_supports("popcnt");
+    return supported;
+}
+
+// rows of B^T visited together: a block of B^T stays in L2 while the rows of A stream by
+constexpr std::size_t kBlockBytes = 256 * 1024;
+
+/**
+ * c[j] = 1 where row j of Bt (j in [j0, j1)) shares a set bit with a; `words` is the
+ * padded row length, a multiple of 8, so the vector loops need no tail.
+ */
+void rowBooleanPortable(const std::uint64_t* a, const BitMatrix& Bt, int j0, int j1, std::uint64_t* c) {
+    for (int j = j0; j < j1; ++j) {
+        const std::uint64_t* b = Bt.row(j);
+        for (int w = 0; w < Bt.words; ++w) {
+            if (a[w] & b[w]) {
+                c[j / 64] |= std::uint64_t(1) << (j % 64);
+                break;
+            }
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+void rowBooleanAvx2(const std::uint64_t* a, const BitMatrix& Bt, int j0, int j1, std::uint64_t* c) {
+    for (int j = j0; j < j1; ++j) {
+        const std::uint64_t* b = Bt.row(j);
+        for (int w = 0; w < Bt.words; w += 4) {
+            const __m256i va = _mm256_load_si256(reinterpret_cast<const __m256i*>(a + w));
+            const __m256i vb = _mm256_load_si256(reinterpret_cast<const __m256i*>(b + w));
+            if (!_mm256_testz_si256(va, vb)) {
+                c[j / 64] |= std::uint64_t(1) << (j % 64);
+                break;
+            }
+        }
+    }
+}
+
+__attribute__((target("avx512f")))
+void rowBooleanAvx512(const std::uint64_t* a, const BitMatrix& Bt, int j0, int j1, std::uint64_t* c) {
+    for (int j = j0; j < j1; ++j) {
+        const std::uint64_t* b = Bt.row(j);
+        for (int w = 0; w < Bt.words; w += 8) {
+            if (_mm512_test_epi64_mask(_mm512_load_si512(a + w), _mm512_load_si512(b + w))) {
+                c[j / 64] |= std::uint64_t(1) << (j % 64);
+                break;
+            }
+        }
+    }
+}
+
+void rowCountPortable(const std::uint64_t* a, const BitMatrix& Bt, int j0, int j1, int* c) {
+    for (int j = j0; j < j1; ++j) {
+        const std::uint64_t* b = Bt.row(j);
+        int count = 0;
+        for (int w = 0; w < Bt.words; ++w) {
+            count += __builtin_popcountll(a[w] & b[w]);
+        }
+        c[j] = count;
+    }
+}
+
+__attribute__((target("popcnt")))
+void rowCountPopcnt(const std::uint64_t* a, const BitMatrix& Bt, int j0, int j1, int* c) {
+    for (int j = j0; j < j1; ++j) {
+        const std::uint64_t* b = Bt.row(j);
+        int count = 0;
+        for (int w = 0; w < Bt.words; ++w) {
+            count += static_cast<int>(_mm_popcnt_u64(a[w] & b[w]));
+        }
+        c[j] = count;
+    }
+}
+
+/**
+ * Sum of the 8 lanes, halving with masked extracts from explicit zero vectors: the unmasked
+ * extracts (and _mm512_reduce_add_epi64, built on them) pass an undefined vector that GCC 12
+ * reports with -Wmaybe-uninitialized.
+ */
+__attribute__((target("avx512f")))
+long long sumLanes(__m512i v) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i half = _mm256_add_epi64(_mm512_mask_extracti64x4_epi64(zero, 0xf, v, 0),
+                                          _mm512_mask_extracti64x4_epi64(zero, 0xf, v, 1));
+    const __m128i quarter = _mm_add_epi64(_mm256_castsi256_si128(half), _mm256_extracti128_si256(half, 1));
+    return _mm_cvtsi128_si64(quarter) + _mm_extract_epi64(quarter, 1);
+}
+
+__attribute__((target("avx512f,avx512vpopcntdq")))
+void rowCountAvx512(const std::uint64_t* a, const BitMatrix& Bt, int j0, int j1, int* c) {
+    for (int j = j0; j < j1; ++j) {
+        const std::uint64_t* b = Bt.row(j);
+        __m512i count = _mm512_setzero_si512();
+        for (int w = 0; w < Bt.words; w += 8) {
+            count = _mm512_add_epi64(count, _mm512_popcnt_epi64(_mm512_and_si512(_mm512_load_si512(a + w),
+                                                                                 _mm512_load_si512(b + w))));
+        }
+        c[j] = static_cast<int>(sumLanes(count));
+    }
+}
+
+/**
+ * Shared loop of the two kernels: each thread takes a static block of rows of A and walks
+ * B^T in cache sized blocks of rows, calling row(A row i, Bt, j0, j1, output row i).
+ */
+template <typename Row>
+void forEachRowBlock(const BitMatrix& A, const BitMatrix& Bt, Row row) {
+    const int blockRows = std::max(1, static_cast<int>(kBlockBytes / (std::max(Bt.words, 1) * sizeof(std::uint64_t))));
+#pragma omp parallel
+    {
+        int threads = 1, tid = 0;
+#ifdef _OPENMP
+        threads = omp_get_num_threads();
+        tid = omp_get_thread_num();
+#endif
+        int begin, end;
+        blockRange(A.rows, threads, tid, begin, end);
+        for (int j0 = 0; begin < end && j0 < Bt.rows; j0 += blockRows) {
+            const int j1 = std::min(j0 + blockRows, Bt.rows);
+            for (int i = begin; i < end; ++i) {
+                row(i, j0, j1);
+            }
+        }
+    }
+}
+
+}
+
+int paddedWords(int cols) {
+    constexpr int kWordsPerLine = static_cast<int>(Arena::kAlignment / sizeof(std::uint64_t));
+    return ((cols + 63) / 64 + kWordsPerLine - 1) / kWordsPerLine * kWordsPerLine;
+}
+
+BitMatrix allocateBitMatrix(Arena& arena, int rows, int cols) {
+    BitMatrix M;
+    M.rows = rows;
+    M.cols = cols;
+    M.words = paddedWords(cols);
+    M.data = arena.allocateArray<std::uint64_t>(M.storageSize());
+    std::fill(M.data, M.data + M.storageSize(), 0);
+    return M;
+}
+
+BitMatrix rowBlock(const BitMatrix& M, int begin, int count) {
+    BitMatrix block = M;
+    block.rows = count;
+    block.data = M.data + static_cast<std::size_t>(begin) * M.words;
+    return block;
+}
+
+BitMatrix packBits(const Matrix& M, Arena& arena) {
+    BitMatrix bits = allocateBitMatrix(arena, M.rows, M.cols);
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < M.rows; ++i) {
+        const int* r = M.row(i);
+        std::uint64_t* b = bits.row(i);
+        for (int j = 0; j < M.cols; ++j) {
+            b[j / 64] |= static_cast<std::uint64_t>(r[j] != 0) << (j % 64);
+        }
+    }
+    return bits;
+}
+
+void unpackBits(const BitMatrix& bits, Matrix& M) {
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < bits.rows; ++i) {
+        int* r = M.row(i);
+        for (int j = 0; j < bits.cols; ++j) {
+            r[j] = bits.get(i, j) ? 1 : 0;
+        }
+        std::fill(r + bits.cols, r + M.span(), 0);
+    }
+}
+
+BitMatrix transposeBits(const BitMatrix& M, Arena& arena) {
+    BitMatrix T = allocateBitMatrix(arena, M.cols, M.rows);
+    const int columnWords = (M.cols + 63) / 64;
+    // each thread owns whole words of columns of M, i.e. whole rows of T
+#pragma omp parallel
+    {
+        int threads = 1, tid = 0;
+#ifdef _OPENMP
+        threads = omp_get_num_threads();
+        tid = omp_get_thread_num();
+#endif
+        int begin, end;
+        blockRange(columnWords, threads, tid, begin, end);
+        for (int i = 0; i < M.rows; ++i) {
+            const std::uint64_t* r = M.row(i);
+            for (int w = begin; w < end; ++w) {
+                for (std::uint64_t bits = r[w]; bits != 0; bits &= bits - 1) {
+                    T.set(w * 64 + __builtin_ctzll(bits), i);
+                }
+            }
+        }
+    }
+    return T;
+}
+
+bool readBitMatrixFromFile(const std::string& filename, Arena& arena, BitMatrix& matrix) {
+    std::ifstream infile(filename);
+    int rows, cols;
+    if (!infile || !(infile >> rows >> cols) || rows < 0 || cols < 0) {
+        return false;
+    }
+    matrix = allocateBitMatrix(arena, rows, cols);
+
+    // one character per element: the entries are tokens "0" or "1" separated by white space
+    std::streambuf* in = infile.rdbuf();
+    for (int i = 0; i < rows; ++i) {
+        std::uint64_t* r = matrix.row(i);
+        for (int j = 0; j < cols; ++j) {
+            int ch = in->sbumpc();
+            while (ch != std::char_traits<char>::eof() && std::isspace(ch)) {
+                ch = in->sbumpc();
+            }
+            if (ch != '0' && ch != '1') {
+                return false;
+            }
+            const int next = in->sgetc();
+            if (next != std::char_traits<char>::eof() && !std::isspace(next)) {
+                return false;
+            }
+            r[j / 64] |= static_cast<std::uint64_t>(ch - '0') << (j % 64);
+        }
+    }
+    return true;
+}
+
+void writeBitMatrix(std::ostream& out, const BitMatrix& M) {
+    std::string line;
+    for (int i = 0; i < M.rows; ++i) {
+        line.clear();
+        for (int j = 0; j < M.cols; ++j) {
+            line += M.get(i, j) ? "1 " : "0 ";
+        }
+        line += '\n';
+        out << line;
+    }
+    out.flush();
+}
+
+void multiplyBooleanTransposed(const BitMatrix& A, const BitMatrix& Bt, BitMatrix& C) {
+    std::fill(C.data, C.data + C.storageSize(), 0);
+    auto kernel = hasAvx512() ? rowBooleanAvx512 : hasAvx2() ? rowBooleanAvx2 : rowBooleanPortable;
+    forEachRowBlock(A, Bt, [&](int i, int j0, int j1) {
+        kernel(A.row(i), Bt, j0, j1, C.row(i));
+    });
+}
+
+void multiplyBoolean(const BitMatrix& A, const BitMatrix& B, BitMatrix& C, Arena& workspace) {
+    Arena::Scope scratch(workspace);
+    multiplyBooleanTransposed(A, transposeBits(B, workspace), C);
+}
+
+void countBoolean(const BitMatrix& A, const BitMatrix& B, Matrix& C, Arena& workspace) {
+    Arena::Scope scratch(workspace);
+    const BitMatrix Bt = transposeBits(B, workspace);
+    auto kernel = hasAvx512Popcount() ? rowCountAvx512 : hasPopcount() ? rowCountPopcnt : rowCountPortable;
+    forEachRowBlock(A, Bt, [&](int i, int j0, int j1) {
+        int* c = C.row(i);
+        kernel(A.row(i), Bt, j0, j1, c);
+        if (j1 == Bt.rows) {
+            std::fill(c + C.cols, c + C.span(), 0);
+        }
+    });
+}
+
+BitMatrix distributedMultiplyBoolean(const BitMatrix& A, const BitMatrix& B, MPI_Comm comm,
+                                     Arena& storage, PhaseTimes* timings) {
+    PhaseTimes unused;
+    PhaseTimes& times = timings != nullptr ? *timings : unused;
+    double last = MPI_Wtime();
+    auto lap = [&last]() {
+        const double now = MPI_Wtime();
+        const double seconds = now - last;
+        last = now;
+        return seconds;
+    };
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    int dims[4] = {A.rows, A.cols, B.rows, B.cols};
+    MPI_Bcast(dims, 4, MPI_INT, 0, comm);
+    const int rowsA = dims[0], colsA = dims[1], rowsB = dims[2], colsB = dims[3];
+
+    int* counts = storage.allocateArray<int>(size);
+    int* displs = storage.allocateArray<int>(size);
+    for (int r = 0; r < size; ++r) {
+        int begin, end;
+        blockRange(rowsA, size, r, begin, end);
+        displs[r] = begin;
+        counts[r] = end - begin;
+    }
+    const int myRows = counts[rank];
+
+    // rows of A have colsA bits, rows of B^T rowsB bits (the same number when the shapes match)
+    MPI_Datatype rowA, rowBt, rowC;
+    MPI_Type_contiguous(paddedWords(colsA), MPI_UINT64_T, &rowA);
+    MPI_Type_contiguous(paddedWords(rowsB), MPI_UINT64_T, &rowBt);
+    MPI_Type_contiguous(paddedWords(colsB), MPI_UINT64_T, &rowC);
+    MPI_Type_commit(&rowA);
+    MPI_Type_commit(&rowBt);
+    MPI_Type_commit(&rowC);
+
+    BitMatrix localA, Bt, localC, C;
+    if (rank == 0) {
+        localA = rowBlock(A, displs[0], myRows);
+        Bt = transposeBits(B, storage);
+        C = allocateBitMatrix(storage, rowsA, colsB);
+        localC = rowBlock(C, displs[0], myRows);
+        MPI_Scatterv(A.data, counts, displs, rowA, MPI_IN_PLACE, myRows, rowA, 0, comm);
+    } else {
+        localA = allocateBitMatrix(storage, myRows, colsA);
+        Bt = allocateBitMatrix(storage, colsB, rowsB);
+        localC = allocateBitMatrix(storage, myRows, colsB);
+        MPI_Scatterv(nullptr, counts, displs, rowA, localA.data, myRows, rowA, 0, comm);
+    }
+    MPI_Bcast(Bt.data, colsB, rowBt, 0, comm);
+    times.distribute = lap();
+
+    multiplyBooleanTransposed(localA, Bt, localC);
+    times.compute = lap();
+
+    if (rank == 0) {
+        MPI_Gatherv(MPI_IN_PLACE, myRows, rowC, C.data, counts, displs, rowC, 0, comm);
+    } else {
+        MPI_Gatherv(localC.data, myRows, rowC, nullptr, counts, displs, rowC, 0, comm);
+    }
+    MPI_Type_free(&rowA);
+    MPI_Type_free(&rowBt);
+    MPI_Type_free(&rowC);
+    times.collect = lap();
+    return C;
+}
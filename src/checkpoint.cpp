@@ -0,0 +1,255 @@
+#include "checkpoint.h"
+#include "placement.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <ostream>
+#include <utility>
+
+namespace {
+
+constexpr char kTileMagic[8] = {'M', 'M', 'T', 'I', 'L', 'E', '0', '1'};
+constexpr std::size_t kMaxQueuedTiles = std::size_t(1) << 16;
+// how often the idle writer looks for a termination signal
+constexpr std::chrono::milliseconds kSignalPoll(50);
+constexpr int kFlushSignals[] = {SIGTERM, SIGINT};
+
+volatile std::sig_atomic_t terminationSignal = 0;
+struct sigaction previousActions[2];
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void recordSignal(int signal) {
+    terminationSignal = signal;
+}
+
+void installSignalHandlers() {
+    terminationSignal = 0;
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = recordSignal;
+    action.sa_flags = SA_RESTART;  // the other threads go on until the writer is done
+    sigemptyset(&action.sa_mask);
+    for (int i = 0; i < 2; ++i) {
+        sigaction(kFlushSignals[i], &action, &previousActions[i]);
+    }
+}
+
+void restoreSignalHandlers() {
+    for (int i = 0; i < 2; ++i) {
+        sigaction(kFlushSignals[i], &previousActions[i], nullptr);
+    }
+}
+
+/**
+ * Delete the tile files of `directory`, all of them or only those of another key than `keep`.
+ */
+void removeTiles(const std::string& directory, const std::string* keep) {
+    DIR* dir = opendir(directory.c_str());
+    if (dir == nullptr) {
+        return;
+    }
+    while (dirent* entry = readdir(dir)) {
+        if (std::strncmp(entry->d_name, "tile_", 5) != 0 || std::strstr(entry->d_name, ".bin") == nullptr) {
+            continue;
+        }
+        const std::string path = directory + "/" + entry->d_name;
+        if (keep != nullptr) {
+            char magic[sizeof(kTileMagic)];
+            char key[32];
+            std::ifstream in(path, std::ios::binary);
+            if (in.read(magic, sizeof(magic)) && std::memcmp(magic, kTileMagic, sizeof(magic)) == 0 &&
+                in.read(key, sizeof(key)) && keep->compare(0, std::string::npos, key, sizeof(key)) == 0) {
+                continue;
+            }
+        }
+        std::remove(path.c_str());
+    }
+    closedir(dir);
+}
+
+}
+
+Checkpointer::Checkpointer(std::string directory, double intervalSeconds, bool resume,
+                           std::vector<int> writerCpus)
+    : directory_(std::move(directory)), intervalSeconds_(intervalSeconds), resume_(resume),
+      writerCpus_(std::move(writerCpus)), queue_(kMaxQueuedTiles) {}
+
+Checkpointer::~Checkpointer() {
+    finish();
+}
+
+std::string Checkpointer::tilePath(int tile) const {
+    return directory_ + "/tile_" + std::to_string(tile) + ".bin";
+}
+
+int Checkpointer::begin(MPI_Comm comm, const CacheKey& key, int rowsA, int colsB, int defaultTileRows) {
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+
+    // [0] tile rows, [1] resumed
+    int agreed[2] = {defaultTileRows, 0};
+    char hex[33] = {0};
+    if (rank == 0) {
+        mkdir(directory_.c_str(), 0777);
+        std::snprintf(hex, sizeof(hex), "%s", key.hex().c_str());
+        const std::string meta = directory_ + "/checkpoint.meta";
+        std::string storedKey;
+        int storedRows = -1, storedCols = -1, storedTileRows = 0;
+        std::ifstream in(meta);
+        if (resume_ && in >> storedKey >> storedRows >> storedCols >> storedTileRows &&
+            storedKey == hex && storedRows == rowsA && storedCols == colsB && storedTileRows > 0) {
+            agreed[0] = storedTileRows;
+            agreed[1] = 1;
+            removeTiles(directory_, &storedKey);
+        } else {
+            // fresh checkpoint: nothing in the directory belongs to it
+            removeTiles(directory_, nullptr);
+            const std::string temp = meta + ".tmp";
+            std::ofstream out(temp);
+            out << hex << " " << rowsA << " " << colsB << " " << defaultTileRows << "\n";
+            out.close();
+            std::rename(temp.c_str(), meta.c_str());
+        }
+    }
+    MPI_Bcast(agreed, 2, MPI_INT, 0, comm);
+    MPI_Bcast(hex, sizeof(hex), MPI_CHAR, 0, comm);
+
+    key_ = hex;
+    cols_ = colsB;
+    tileRows_ = agreed[0];
+    resumed_ = agreed[1] != 0;
+    lastFlush_ = std::chrono::steady_clock::now();
+    installSignalHandlers();
+    writer_ = std::thread([this] { runWriter(); });
+    pinHelperThread(writer_, writerCpus_);
+    return tileRows_;
+}
+
+bool Checkpointer::restore(int tile, Matrix& tileC) {
+    if (!resumed_) {
+        return false;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    std::ifstream in(tilePath(tile), std::ios::binary);
+    char magic[sizeof(kTileMagic)];
+    char key[32];
+    int header[3];
+    if (!in || !in.read(magic, sizeof(magic)) || std::memcmp(magic, kTileMagic, sizeof(magic)) != 0 ||
+        !in.read(key, sizeof(key)) || key_.compare(0, std::string::npos, key, sizeof(key)) != 0 ||
+        !in.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+        header[0] != tile || header[1] != tileC.rows || header[2] != tileC.cols) {
+        return false;
+    }
+    for (int i = 0; i < tileC.rows; ++i) {
+        if (!in.read(reinterpret_cast<char*>(tileC.row(i)), static_cast<std::streamsize>(tileC.cols) * sizeof(int))) {
+            return false;
+        }
+        std::fill(tileC.row(i) + tileC.cols, tileC.row(i) + tileC.span(), 0);
+    }
+    ++stats_.tilesRestored;
+    stats_.restoreSeconds += secondsSince(start);
+    return true;
+}
+
+void Checkpointer::completed(int tile, const Matrix& tileC) {
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        pending_.push_back({tile, tileC});
+    }
+    if (secondsSince(lastFlush_) >= intervalSeconds_) {
+        flush();
+    }
+}
+
+void Checkpointer::flush() {
+    std::vector<PendingTile> tiles;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        tiles.swap(pending_);
+    }
+    for (PendingTile& pending : tiles) {
+        queue_.push(pending);
+    }
+    lastFlush_ = std::chrono::steady_clock::now();
+}
+
+void Checkpointer::runWriter() {
+    PendingTile pending;
+    for (;;) {
+        if (queue_.popFor(pending, kSignalPoll)) {
+            writeTile(pending);
+        } else if (terminationSignal != 0) {
+            // queued tiles are written (the queue is empty now), then those waiting for the
+            // interval; the tiles stay valid since the main thread never frees them before finish()
+            const int signal = terminationSignal;
+            std::vector<PendingTile> tiles;
+            {
+                std::lock_guard<std::mutex> lock(pendingMutex_);
+                tiles.swap(pending_);
+            }
+            for (const PendingTile& tile : tiles) {
+                writeTile(tile);
+            }
+            // a flush() may have raced with the swap above
+            while (queue_.popFor(pending, std::chrono::milliseconds(0))) {
+                writeTile(pending);
+            }
+            restoreSignalHandlers();
+            std::signal(signal, SIG_DFL);
+            std::raise(signal);
+        } else if (queue_.drained()) {
+            return;
+        }
+    }
+}
+
+void Checkpointer::writeTile(const PendingTile& pending) {
+    const auto start = std::chrono::steady_clock::now();
+    const std::string final = tilePath(pending.index);
+    const std::string temp = final + ".tmp." + std::to_string(getpid());
+    const Matrix& tile = pending.tile;
+    const int header[3] = {pending.index, tile.rows, tile.cols};
+    std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+    out.write(kTileMagic, sizeof(kTileMagic));
+    out.write(key_.data(), 32);
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    for (int i = 0; i < tile.rows; ++i) {
+        out.write(reinterpret_cast<const char*>(tile.row(i)), static_cast<std::streamsize>(tile.cols) * sizeof(int));
+    }
+    out.close();
+    if (out && std::rename(temp.c_str(), final.c_str()) == 0) {
+        ++stats_.tilesWritten;
+        stats_.bytesWritten += sizeof(kTileMagic) + 32 + sizeof(header) +
+                               static_cast<std::uint64_t>(tile.rows) * tile.cols * sizeof(int);
+    } else {
+        std::remove(temp.c_str());
+    }
+    stats_.writeSeconds += secondsSince(start);
+}
+
+void Checkpointer::finish() {
+    if (writer_.joinable()) {
+        flush();
+    }
+    queue_.close();
+    if (writer_.joinable()) {
+        writer_.join();
+        restoreSignalHandlers();
+    }
+}
+
+void Checkpointer::report(std::ostream& out, int rank) const {
+    out << "[rank " << rank << "] checkpoint: tile_rows=" << tileRows_
+        << " resumed=" << (resumed_ ? "yes" : "no")
+        << " restored=" << stats_.tilesRestored << " (" << stats_.restoreSeconds << " s)"
+        << " written=" << stats_.tilesWritten << " (" << stats_.bytesWritten << " bytes, "
+        << stats_.writeSeconds << " s async)" << std::endl;
+}
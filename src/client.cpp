@@ -0,0 +1,88 @@
+#include "arena.h"
+#include "matrix.h"
+#include "service_protocol.h"
+#include <unistd.h>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+/**
+ * Client of the service mode of main (main --serve SOCKET).
+ *
+ *   matmul_client SOCKET A.txt B.txt            the service reads the files
+ *   matmul_client SOCKET --inline A.txt B.txt   the client reads them and sends the elements
+ *   matmul_client SOCKET --shutdown             stop the service
+ *
+ * The product is printed on stdout in the same layout used by main.
+ */
+int usage() {
+    std::cerr << "usage: matmul_client SOCKET [--inline] A.txt B.txt | matmul_client SOCKET --shutdown" << std::endl;
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        return usage();
+    }
+    const std::string socketPath = argv[1];
+    RequestType type = RequestType::Paths;
+    int first = 2;
+    if (std::strcmp(argv[2], "--shutdown") == 0) {
+        type = RequestType::Shutdown;
+    } else if (std::strcmp(argv[2], "--inline") == 0) {
+        type = RequestType::Inline;
+        first = 3;
+    }
+    if (type != RequestType::Shutdown && argc != first + 2) {
+        return usage();
+    }
+
+    Arena arena;
+    Matrix A, B;
+    if (type == RequestType::Inline) {
+        for (int i = 0; i < 2; ++i) {
+            if (!readMatrixFromFile(argv[first + i], arena, i == 0 ? A : B)) {
+                std::cerr << "Error opening file: " << argv[first + i] << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    const int fd = connectToSocket(socketPath);
+    if (fd < 0) {
+        std::cerr << "Cannot connect to " << socketPath << std::endl;
+        return 1;
+    }
+    bool sent = sendU32(fd, kRequestMagic) && sendU32(fd, static_cast<std::uint32_t>(type));
+    if (type == RequestType::Paths) {
+        sent = sent && sendString(fd, argv[first]) && sendString(fd, argv[first + 1]);
+    } else if (type == RequestType::Inline) {
+        sent = sent && sendMatrix(fd, A) && sendMatrix(fd, B);
+    }
+
+    std::uint32_t status;
+    if (!sent || !recvU32(fd, status)) {
+        std::cerr << "Connection to the service lost" << std::endl;
+        close(fd);
+        return 1;
+    }
+    if (status != static_cast<std::uint32_t>(ResponseStatus::Ok)) {
+        std::string message;
+        recvString(fd, message);
+        std::cerr << "Service error: " << message << std::endl;
+        close(fd);
+        return 1;
+    }
+    if (type != RequestType::Shutdown) {
+        Matrix C;
+        if (!recvMatrix(fd, arena, C)) {
+            std::cerr << "Connection to the service lost" << std::endl;
+            close(fd);
+            return 1;
+        }
+        writeMatrix(std::cout, C);
+    }
+    close(fd);
+    return 0;
+}
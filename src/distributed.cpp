@@ -0,0 +1,671 @@
+#include "distributed.h"
+#include "checkpoint.h"
+#include "kernels.h"
+#include "modular.h"
+#include "node_shared.h"
+#include "perf_counters.h"
+#include "placement.h"
+#include "progress.h"
+#include <algorithm>
+#include <memory>
+
+namespace {
+
+/**
+ * Phase boundaries of distributedMultiply: each lap returns the wall time since the previous
+ * one and, with counters, records the hardware counts of the phase under its name.
+ */
+class PhaseClock {
+public:
+    explicit PhaseClock(PerfCounters* counters) : counters_(counters), last_(MPI_Wtime()) {
+        if (counters_ != nullptr) {
+            values_ = counters_->read();
+        }
+    }
+
+    double lap(const char* phase, double flops = 0) {
+        const double now = MPI_Wtime();
+        const double seconds = now - last_;
+        last_ = now;
+        if (counters_ != nullptr) {
+            const CounterValues values = counters_->read();
+            counters_->add(phase, values - values_, flops, seconds);
+            values_ = values;
+        }
+        return seconds;
+    }
+
+private:
+    PerfCounters* counters_;
+    double last_;
+    CounterValues values_;
+};
+
+/**
+ * multiplyAuto (multiplyModular or multiplySemiring when asked), with the hardware counts
+ * of the call recorded under "kernel <name>". Int32 operands without structure end up in
+ * gemm(1, A, B, 0, C): the engines give every rank whole rows of C or reduce the partial
+ * products with MPI, so none of them accumulates into C with beta = 1.
+ */
+void runKernel(const Matrix& A, const Matrix& B, Matrix& C, Arena& workspace,
+               const DistributedOptions& options, int rowOffsetA) {
+    KernelReport local;
+    KernelReport* report = options.report != nullptr ? options.report : &local;
+    const CounterValues before = options.counters != nullptr ? options.counters->read() : CounterValues();
+    const double start = MPI_Wtime();
+    if (options.modulus != 0) {
+        multiplyModular(A, B, C, Modulus(options.modulus), workspace);
+        report->kernel = "modular";
+    } else if (options.semiring != SemiringKind::PlusTimes) {
+        multiplySemiring(options.semiring, A, B, C, workspace);
+        report->kernel = semiringName(options.semiring);
+    } else {
+        // without counters the structure is only described if someone reads the report
+        multiplyAuto(A, B, C, workspace, options.counters != nullptr ? report : options.report,
+                     rowOffsetA, options.registry);
+    }
+    if (options.counters != nullptr) {
+        const double seconds = MPI_Wtime() - start;
+        options.counters->add(std::string("kernel ") + report->kernel, options.counters->read() - before,
+                              2.0 * A.rows * A.cols * B.cols, seconds);
+    }
+}
+
+/**
+ * Rows [firstRow, firstRow + M.rows) of the matrix exposed by rank 0 in `window` into M.
+ */
+void getRows(MPI_Win window, Matrix& M, int firstRow, MPI_Datatype row) {
+    MPI_Win_lock(MPI_LOCK_SHARED, 0, MPI_MODE_NOCHECK, window);
+    MPI_Get(M.data, M.rows, row, 0, static_cast<MPI_Aint>(firstRow) * M.stride, M.rows, row, window);
+    MPI_Win_unlock(0, window);
+}
+
+/**
+ * M into rows [firstRow, firstRow + M.rows) of the matrix exposed by rank 0 in `window`.
+ */
+void putRows(MPI_Win window, const Matrix& M, int firstRow, MPI_Datatype row) {
+    MPI_Win_lock(MPI_LOCK_SHARED, 0, MPI_MODE_NOCHECK, window);
+    MPI_Put(M.data, M.rows, row, 0, static_cast<MPI_Aint>(firstRow) * M.stride, M.rows, row, window);
+    MPI_Win_unlock(0, window);
+}
+
+// modulus of the running sumModulo reduction (MPI user functions take no context)
+std::uint32_t reductionModulus = 1;
+
+/**
+ * MPI_Op: inout = (in + inout) mod p on residues in [0, p), p < 2^31 so the sum fits.
+ */
+void sumModulo(void* in, void* inout, int* length, MPI_Datatype*) {
+    const std::uint32_t* a = static_cast<const std::uint32_t*>(in);
+    std::uint32_t* b = static_cast<std::uint32_t*>(inout);
+    const std::uint32_t p = reductionModulus;
+    for (int i = 0; i < *length; ++i) {
+        const std::uint32_t sum = a[i] + b[i];
+        b[i] = sum >= p ? sum - p : sum;
+    }
+}
+
+MPI_Win exposeOnRoot(int rank, const Matrix& M, MPI_Comm comm) {
+    MPI_Win window;
+    const MPI_Aint bytes = rank == 0 ? static_cast<MPI_Aint>(M.storageSize() * sizeof(int)) : 0;
+    MPI_Win_create(rank == 0 ? M.data : nullptr, bytes, sizeof(int), MPI_INFO_NULL, comm, &window);
+    return window;
+}
+
+/**
+ * Fewer rows of A than ranks (a row vector times a matrix, a dot product): a row split would
+ * leave ranks idle, so the inner dimension is split instead. Every rank gets its columns of A
+ * and its rows of B, every rank multiplies its columns of A by its rows of B and the partial products
+ * are summed with an Allreduce (modulo p with a modulus, with the add of the semiring otherwise).
+ */
+Matrix multiplySplitK(const Matrix& A, const Matrix& B, MPI_Comm comm, Arena& storage, Arena& workspace,
+                      const DistributedOptions& options, const int dims[4], PhaseTimes& timings, PhaseClock& clock) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    const int rowsA = dims[0], colsA = dims[1], colsB = dims[3];
+
+    int* counts = storage.allocateArray<int>(size);
+    int* displs = storage.allocateArray<int>(size);
+    for (int r = 0; r < size; ++r) {
+        int begin, end;
+        blockRange(colsA, size, r, begin, end);
+        displs[r] = begin;
+        counts[r] = end - begin;
+    }
+    const int myK = counts[rank];
+
+    MPI_Datatype rowB;
+    MPI_Type_contiguous(paddedStride(colsB), MPI_INT, &rowB);
+    MPI_Type_commit(&rowB);
+
+    // every rank only needs columns [displs[rank], displs[rank] + myK) of A: rank 0 sends
+    // each slice straight out of A with a strided datatype and keeps its own as a view
+    Matrix localA, localB;
+    if (rank == 0) {
+        localA = subMatrix(A, 0, displs[0], rowsA, myK);
+        localB = rowBlock(B, displs[0], myK);
+        MPI_Request* requests = storage.allocateArray<MPI_Request>(size);
+        for (int r = 1; r < size; ++r) {
+            const Matrix slice = subMatrix(A, 0, displs[r], rowsA, counts[r]);
+            MPI_Datatype type = matrixDatatype(slice);
+            MPI_Isend(slice.data, 1, type, r, 0, comm, &requests[r - 1]);
+            MPI_Type_free(&type);
+        }
+        MPI_Scatterv(B.data, counts, displs, rowB, MPI_IN_PLACE, myK, rowB, 0, comm);
+        MPI_Waitall(size - 1, requests, MPI_STATUSES_IGNORE);
+    } else {
+        localA = allocateMatrix(storage, rowsA, myK);
+        fillMatrix(localA, 0);
+        localB = allocateMatrix(storage, myK, colsB);
+        MPI_Datatype type = matrixDatatype(localA);
+        MPI_Recv(localA.data, 1, type, 0, 0, comm, MPI_STATUS_IGNORE);
+        MPI_Type_free(&type);
+        MPI_Scatterv(nullptr, counts, displs, rowB, localB.data, myK, rowB, 0, comm);
+    }
+    timings.distribute = clock.lap("distribute");
+
+    Matrix C = allocateMatrix(storage, rowsA, colsB);
+    if (myK > 0) {
+        runKernel(localA, localB, C, workspace, options, 0);
+    } else {
+        fillMatrix(C, semiringZero(options.semiring));
+    }
+    timings.compute = clock.lap("compute", 2.0 * rowsA * myK * colsB);
+    if (options.modulus != 0) {
+        MPI_Op sum;
+        MPI_Op_create(sumModulo, 1, &sum);
+        reductionModulus = options.modulus;
+        MPI_Allreduce(MPI_IN_PLACE, C.data, static_cast<int>(C.storageSize()), MPI_INT, sum, comm);
+        MPI_Op_free(&sum);
+    } else {
+        // the add of the semiring: sum, min (min-plus) or max (max-plus, max-min)
+        const MPI_Op add = options.semiring == SemiringKind::PlusTimes ? MPI_SUM
+                         : options.semiring == SemiringKind::MinPlus ? MPI_MIN : MPI_MAX;
+        MPI_Allreduce(MPI_IN_PLACE, C.data, static_cast<int>(C.storageSize()), MPI_INT, add, comm);
+    }
+    timings.collect = clock.lap("collect");
+
+    MPI_Type_free(&rowB);
+    return C;
+}
+
+
+/**
+ * Dynamic schedule: the rows of C are cut in guided ranges (see guidedRanges) and every rank,
+ * rank 0 included, claims the next range with an atomic MPI_Fetch_and_op on a counter held by
+ * rank 0, gets its rows of A, multiplies them and puts the rows of C back, until none is left.
+ * B is broadcast (or shared per node) up front since every range needs all of it.
+ */
+Matrix multiplyDynamic(const Matrix& A, const Matrix& B, MPI_Comm comm, Arena& storage, Arena& workspace,
+                       const DistributedOptions& options, const int dims[4], PhaseTimes& timings, PhaseClock& clock) {
+    constexpr int kMinTileRows = 8;
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    const int rowsA = dims[0], colsA = dims[1], rowsB = dims[2], colsB = dims[3];
+    const std::vector<int> bounds = guidedRanges(rowsA, size, kMinTileRows);
+    const int tiles = static_cast<int>(bounds.size()) - 1;
+    const int largestTile = tiles > 0 ? bounds[1] : 0;
+
+    MPI_Datatype rowA, rowB;
+    MPI_Type_contiguous(paddedStride(colsA), MPI_INT, &rowA);
+    MPI_Type_contiguous(paddedStride(colsB), MPI_INT, &rowB);
+    MPI_Type_commit(&rowA);
+    MPI_Type_commit(&rowB);
+
+    std::unique_ptr<NodeSharedMatrix> sharedB;
+    Matrix localB, C, tileA, tileC;
+    int* next = nullptr;
+    if (options.sharedB) {
+        sharedB.reset(new NodeSharedMatrix(comm, rowsB, colsB));
+        sharedB->broadcast(B, options.interleaveB);
+        localB = sharedB->matrix();
+    } else {
+        if (rank == 0) {
+            localB = B;
+        } else {
+            localB = allocateMatrix(storage, rowsB, colsB);
+            firstTouchRows(localB);
+        }
+        MPI_Bcast(localB.data, rowsB, rowB, 0, comm);
+    }
+    if (rank == 0) {
+        C = allocateMatrix(storage, rowsA, colsB);
+        next = storage.allocateArray<int>(1);
+        *next = 0;
+    } else {
+        tileA = allocateMatrix(storage, largestTile, colsA);
+        tileC = allocateMatrix(storage, largestTile, colsB);
+    }
+    MPI_Win windowA = exposeOnRoot(rank, A, comm);
+    MPI_Win windowC = exposeOnRoot(rank, C, comm);
+    MPI_Win counter;
+    MPI_Win_create(next, rank == 0 ? sizeof(int) : 0, sizeof(int), MPI_INFO_NULL, comm, &counter);
+    timings.distribute = clock.lap("distribute");
+
+    ScheduleReport unused;
+    ScheduleReport& schedule = options.schedule != nullptr ? *options.schedule : unused;
+    schedule = ScheduleReport();
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, counter);
+    for (;;) {
+        const int one = 1;
+        int tile;
+        MPI_Fetch_and_op(&one, &tile, MPI_INT, 0, 0, MPI_SUM, counter);
+        MPI_Win_flush(0, counter);
+        if (tile >= tiles) {
+            break;
+        }
+        const int first = bounds[tile];
+        const int rows = bounds[tile + 1] - first;
+        if (rank == 0) {
+            Matrix c = rowBlock(C, first, rows);
+            runKernel(rowBlock(A, first, rows), localB, c, workspace, options, first);
+        } else {
+            Matrix a = rowBlock(tileA, 0, rows);
+            Matrix c = rowBlock(tileC, 0, rows);
+            getRows(windowA, a, first, rowA);
+            runKernel(a, localB, c, workspace, options, first);
+            putRows(windowC, c, first, rowB);
+        }
+        ++schedule.tiles;
+        schedule.rows += rows;
+    }
+    MPI_Win_unlock_all(counter);
+    timings.compute = clock.lap("compute", 2.0 * schedule.rows * colsA * colsB);
+
+    MPI_Win_free(&counter);
+    MPI_Win_free(&windowA);
+    MPI_Win_free(&windowC);
+    timings.collect = clock.lap("collect");
+
+    MPI_Type_free(&rowA);
+    MPI_Type_free(&rowB);
+    return C;
+}
+
+/**
+ * Row-block product streamed through the progress threads: the row block of every rank is cut
+ * in chunks of about 1 / kOverlapChunks of a block (at least kMinChunkRows rows), and every
+ * chunk of A and of C is one message posted by a progress thread, tagged with its chunk index. Rank 0 queues all the
+ * chunks of A to send and of C to receive before broadcasting B and computing its own block;
+ * the other ranks queue the receives of their chunks of A, then multiply each chunk as soon
+ * as it is in and queue its rows of C straight back. The calling threads only wait at the end.
+ */
+Matrix multiplyOverlapped(const Matrix& A, const Matrix& B, MPI_Comm comm, Arena& storage, Arena& workspace,
+                          const DistributedOptions& options, const int dims[4], PhaseTimes& timings,
+                          PhaseClock& clock) {
+    constexpr int kOverlapChunks = 4;
+    constexpr int kMinChunkRows = 16;
+    ProgressThread& progress = *options.progress;
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    const int rowsA = dims[0], colsA = dims[1], rowsB = dims[2], colsB = dims[3];
+
+    int* counts = storage.allocateArray<int>(size);
+    int* displs = storage.allocateArray<int>(size);
+    int* firstChunk = storage.allocateArray<int>(size + 1);
+    const int chunkRows = std::max(kMinChunkRows, (rowsA + kOverlapChunks * size - 1) / (kOverlapChunks * size));
+    firstChunk[0] = 0;
+    for (int r = 0; r < size; ++r) {
+        int begin, end;
+        blockRange(rowsA, size, r, begin, end);
+        displs[r] = begin;
+        counts[r] = end - begin;
+        firstChunk[r + 1] = firstChunk[r] + (counts[r] + chunkRows - 1) / chunkRows;
+    }
+    const int chunks = firstChunk[size];
+    const int myRows = counts[rank];
+
+    MPI_Datatype rowA, rowB;
+    MPI_Type_contiguous(paddedStride(colsA), MPI_INT, &rowA);
+    MPI_Type_contiguous(paddedStride(colsB), MPI_INT, &rowB);
+    MPI_Type_commit(&rowA);
+    MPI_Type_commit(&rowB);
+
+    // the progress thread talks on its own communicator, so that its messages can never match
+    // anything of this thread's collectives on comm
+    MPI_Comm channel;
+    MPI_Comm_dup(comm, &channel);
+
+    // rows [first, first + rows) of the block of rank `owner`, relative to that block
+    auto chunkBounds = [&](int chunk, int owner, int& first, int& rows) {
+        first = (chunk - firstChunk[owner]) * chunkRows;
+        rows = std::min(chunkRows, counts[owner] - first);
+    };
+    auto prepare = [&](Transfer& transfer, Transfer::Kind kind, const int* buffer, int rows, MPI_Datatype type,
+                       int peer, int tag) {
+        transfer.kind = kind;
+        transfer.buffer = const_cast<int*>(buffer);
+        transfer.count = rows;
+        transfer.type = type;
+        transfer.peer = peer;
+        transfer.tag = tag;
+        transfer.comm = channel;
+    };
+
+    // transfers[chunk] moves a chunk of A, transfers[chunks + chunk] the same rows of C
+    std::unique_ptr<Transfer[]> transfers(new Transfer[2 * chunks]);
+    Matrix localA, localB, localC, C;
+    if (rank == 0) {
+        C = allocateMatrix(storage, rowsA, colsB);
+        for (int chunk = firstChunk[1]; chunk < chunks; ++chunk) {
+            int owner = 1;
+            while (chunk >= firstChunk[owner + 1]) {
+                ++owner;
+            }
+            int first, rows;
+            chunkBounds(chunk, owner, first, rows);
+            Transfer& a = transfers[chunk];
+            Transfer& c = transfers[chunks + chunk];
+            prepare(a, Transfer::Kind::Send, A.row(displs[owner] + first), rows, rowA, owner, chunk);
+            prepare(c, Transfer::Kind::Receive, C.row(displs[owner] + first), rows, rowB, owner, chunk);
+            progress.submit(a);
+            progress.submit(c);
+        }
+        localA = rowBlock(A, 0, myRows);
+        localB = B;
+        localC = rowBlock(C, 0, myRows);
+    } else {
+        localA = allocateMatrix(storage, myRows, colsA);
+        for (int chunk = firstChunk[rank]; chunk < firstChunk[rank + 1]; ++chunk) {
+            int first, rows;
+            chunkBounds(chunk, rank, first, rows);
+            prepare(transfers[chunk], Transfer::Kind::Receive, localA.row(first), rows, rowA, 0, chunk);
+            progress.submit(transfers[chunk]);
+        }
+        localB = allocateMatrix(storage, rowsB, colsB);
+        firstTouchRows(localB);
+        localC = allocateMatrix(storage, myRows, colsB);
+    }
+    MPI_Bcast(localB.data, rowsB, rowB, 0, comm);
+    timings.distribute = clock.lap("distribute");
+
+    if (rank == 0) {
+        runKernel(localA, localB, localC, workspace, options, 0);
+    } else {
+        for (int chunk = firstChunk[rank]; chunk < firstChunk[rank + 1]; ++chunk) {
+            int first, rows;
+            chunkBounds(chunk, rank, first, rows);
+            ProgressThread::wait(transfers[chunk]);
+            Matrix c = rowBlock(localC, first, rows);
+            runKernel(rowBlock(localA, first, rows), localB, c, workspace, options, displs[rank] + first);
+            prepare(transfers[chunks + chunk], Transfer::Kind::Send, c.data, rows, rowB, 0, chunk);
+            progress.submit(transfers[chunks + chunk]);
+        }
+    }
+    timings.compute = clock.lap("compute", 2.0 * myRows * colsA * colsB);
+
+    // rank 0 waits for every chunk it sent or expects, the others for the chunks of C they sent
+    const int from = rank == 0 ? firstChunk[1] : firstChunk[rank];
+    const int to = rank == 0 ? chunks : firstChunk[rank + 1];
+    for (int chunk = from; chunk < to; ++chunk) {
+        ProgressThread::wait(transfers[chunk]);
+        ProgressThread::wait(transfers[chunks + chunk]);
+    }
+    timings.collect = clock.lap("collect");
+
+    MPI_Comm_free(&channel);
+    MPI_Type_free(&rowA);
+    MPI_Type_free(&rowB);
+    return C;
+}
+}
+
+MPI_Datatype matrixDatatype(const Matrix& M) {
+    MPI_Datatype type;
+    MPI_Type_vector(M.rows, M.cols, M.stride, MPI_INT, &type);
+    MPI_Type_commit(&type);
+    return type;
+}
+
+Matrix distributedMultiply(const Matrix& A, const Matrix& B, MPI_Comm comm,
+                           Arena& storage, Arena& workspace, const DistributedOptions& options) {
+    Checkpointer* checkpointer = options.checkpointer;
+    PhaseTimes unused;
+    PhaseTimes& timings = options.timings != nullptr ? *options.timings : unused;
+    PhaseClock clock(options.counters);
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    int dims[4] = {A.rows, A.cols, B.rows, B.cols};
+    MPI_Bcast(dims, 4, MPI_INT, 0, comm);
+    const int rowsA = dims[0], colsA = dims[1], rowsB = dims[2], colsB = dims[3];
+    if (checkpointer == nullptr && rowsA < size && colsA >= size) {
+        return multiplySplitK(A, B, comm, storage, workspace, options, dims, timings, clock);
+    }
+    if (checkpointer == nullptr && options.dynamic && size > 1) {
+        return multiplyDynamic(A, B, comm, storage, workspace, options, dims, timings, clock);
+    }
+    if (checkpointer == nullptr && options.progress != nullptr && !options.sharedB && !options.oneSided &&
+        size > 1) {
+        return multiplyOverlapped(A, B, comm, storage, workspace, options, dims, timings, clock);
+    }
+
+    // with a checkpoint the rows are dealt in whole tiles, so that a tile never spans two ranks
+    int tileRows = 1;
+    if (checkpointer != nullptr) {
+        const int defaultTileRows = std::max(32, (rowsA + 8 * size - 1) / (8 * size));
+        tileRows = checkpointer->begin(comm, rank == 0 ? operandKey(A, B, options.modulus, options.semiring) : CacheKey(), rowsA, colsB, defaultTileRows);
+    }
+    const int tiles = (rowsA + tileRows - 1) / tileRows;
+
+    // counts and displacements are in rows, one row being `stride` ints (padding included)
+    int* counts = storage.allocateArray<int>(size);
+    int* displs = storage.allocateArray<int>(size);
+    int* firstTile = storage.allocateArray<int>(size + 1);
+    for (int r = 0; r < size; ++r) {
+        int begin, end;
+        blockRange(tiles, size, r, begin, end);
+        firstTile[r] = begin;
+        firstTile[r + 1] = end;
+        displs[r] = std::min(begin * tileRows, rowsA);
+        counts[r] = std::min(end * tileRows, rowsA) - displs[r];
+    }
+    const int myRows = counts[rank];
+
+    // rows of B and C both have colsB elements
+    MPI_Datatype rowA, rowB;
+    MPI_Type_contiguous(paddedStride(colsA), MPI_INT, &rowA);
+    MPI_Type_contiguous(paddedStride(colsB), MPI_INT, &rowB);
+    MPI_Type_commit(&rowA);
+    MPI_Type_commit(&rowB);
+
+    // a single rank has nothing to move
+    const bool oneSided = options.oneSided && size > 1;
+
+    // with sharedB the ranks of a node read B from one shared copy instead of a private one
+    std::unique_ptr<NodeSharedMatrix> sharedB;
+    if (options.sharedB) {
+        sharedB.reset(new NodeSharedMatrix(comm, rowsB, colsB));
+    }
+
+    Matrix localA, localB, localC, C;
+    if (rank == 0) {
+        localA = rowBlock(A, displs[0], myRows);
+        localB = B;
+        if (options.interleaveB && !sharedB) {
+            interleaveMemory(localB.data, localB.storageSize() * sizeof(int));
+        }
+        C = allocateMatrix(storage, rowsA, colsB);
+        localC = rowBlock(C, displs[0], myRows);
+        if (!oneSided) {
+            MPI_Scatterv(A.data, counts, displs, rowA, MPI_IN_PLACE, myRows, rowA, 0, comm);
+        }
+    } else {
+        localA = allocateMatrix(storage, myRows, colsA);
+        firstTouchRows(localA);
+        if (!sharedB) {
+            localB = allocateMatrix(storage, rowsB, colsB);
+            if (!options.interleaveB || !interleaveMemory(localB.data, localB.storageSize() * sizeof(int))) {
+                firstTouchRows(localB);
+            }
+        }
+        localC = allocateMatrix(storage, myRows, colsB);
+        if (!oneSided) {
+            MPI_Scatterv(nullptr, counts, displs, rowA, localA.data, myRows, rowA, 0, comm);
+        }
+    }
+
+    // one-sided: rank 0 only exposes A, B and C, every other rank gets its rows of A and B
+    // and later puts its rows of C, each at its own pace (passive target)
+    MPI_Win windowA = MPI_WIN_NULL, windowB = MPI_WIN_NULL, windowC = MPI_WIN_NULL;
+    if (oneSided) {
+        windowA = exposeOnRoot(rank, A, comm);
+        windowC = exposeOnRoot(rank, C, comm);
+        if (!sharedB) {
+            windowB = exposeOnRoot(rank, B, comm);
+        }
+        if (rank != 0) {
+            getRows(windowA, localA, displs[rank], rowA);
+            if (!sharedB) {
+                getRows(windowB, localB, 0, rowB);
+            }
+        }
+    }
+    if (sharedB) {
+        sharedB->broadcast(B, options.interleaveB);
+        localB = sharedB->matrix();
+    } else if (!oneSided) {
+        MPI_Bcast(localB.data, rowsB, rowB, 0, comm);
+    }
+    timings.distribute = clock.lap("distribute");
+
+    if (checkpointer == nullptr) {
+        runKernel(localA, localB, localC, workspace, options, displs[rank]);
+    } else {
+        for (int tile = firstTile[rank]; tile < firstTile[rank + 1]; ++tile) {
+            const int first = tile * tileRows - displs[rank];
+            const int rows = std::min(tileRows, myRows - first);
+            Matrix tileC = rowBlock(localC, first, rows);
+            if (!checkpointer->restore(tile, tileC)) {
+                runKernel(rowBlock(localA, first, rows), localB, tileC, workspace, options, displs[rank] + first);
+                checkpointer->completed(tile, tileC);
+            }
+        }
+    }
+
+    timings.compute = clock.lap("compute", 2.0 * myRows * colsA * colsB);
+    if (options.schedule != nullptr) {
+        options.schedule->tiles = checkpointer != nullptr ? firstTile[rank + 1] - firstTile[rank] : (myRows > 0 ? 1 : 0);
+        options.schedule->rows = myRows;
+    }
+
+    if (oneSided) {
+        if (rank != 0) {
+            putRows(windowC, localC, displs[rank], rowB);
+        }
+        // freeing is collective and completes every access, so rank 0 then has all of C
+        MPI_Win_free(&windowA);
+        MPI_Win_free(&windowC);
+        if (windowB != MPI_WIN_NULL) {
+            MPI_Win_free(&windowB);
+        }
+    } else if (rank == 0) {
+        MPI_Gatherv(MPI_IN_PLACE, myRows, rowB, C.data, counts, displs, rowB, 0, comm);
+    } else {
+        MPI_Gatherv(localC.data, myRows, rowB, nullptr, counts, displs, rowB, 0, comm);
+    }
+    timings.collect = clock.lap("collect");
+
+    if (checkpointer != nullptr) {
+        checkpointer->finish();
+    }
+    MPI_Type_free(&rowA);
+    MPI_Type_free(&rowB);
+    return C;
+}
+
+Matrix distributedPower(const Matrix& A, int k, MPI_Comm comm, Arena& storage, Arena& workspace,
+                        const DistributedOptions& options) {
+    PhaseTimes unused;
+    PhaseTimes& timings = options.timings != nullptr ? *options.timings : unused;
+    timings = PhaseTimes();
+    PhaseClock clock(options.counters);
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    int n = A.rows;
+    MPI_Bcast(&n, 1, MPI_INT, 0, comm);
+    int* counts = storage.allocateArray<int>(size);
+    int* displs = storage.allocateArray<int>(size);
+    for (int r = 0; r < size; ++r) {
+        int begin, end;
+        blockRange(n, size, r, begin, end);
+        displs[r] = begin;
+        counts[r] = end - begin;
+    }
+    const int myRows = counts[rank];
+
+    Matrix C;
+    if (rank == 0) {
+        C = allocateMatrix(storage, n, n);
+    }
+    if (k == 0) {
+        if (rank == 0) {
+            fillMatrix(C, semiringZero(options.semiring));
+            for (int i = 0; i < n; ++i) {
+                C.at(i, i) = semiringOne(options.semiring);
+                std::fill(C.row(i) + n, C.row(i) + C.stride, 0);
+            }
+        }
+        return C;
+    }
+
+    MPI_Datatype row;
+    MPI_Type_contiguous(paddedStride(n), MPI_INT, &row);
+    MPI_Type_commit(&row);
+
+    // every rank keeps all of A, the right operand of the multiplications by A
+    Matrix fullA = rank == 0 ? A : allocateMatrix(storage, n, n);
+    MPI_Bcast(fullA.data, n, row, 0, comm);
+    timings.distribute = clock.lap("distribute");
+
+    // left-to-right binary exponentiation on this rank's rows: R = R * R for every bit of k
+    // after the leading one, then R = R * A if the bit is set. The products ping-pong between
+    // two row blocks; only the squarings need all of R, which is allgathered into `full`
+    Matrix pingPong[2] = {allocateMatrix(storage, myRows, n), allocateMatrix(storage, myRows, n)};
+    Matrix full = allocateMatrix(storage, n, n);
+    Matrix R = rowBlock(fullA, displs[rank], myRows);
+    int next = 0;
+    int bit = 30;
+    while (!((k >> bit) & 1)) {
+        --bit;
+    }
+    for (--bit; bit >= 0; --bit) {
+        MPI_Allgatherv(R.data, myRows, row, full.data, counts, displs, row, comm);
+        timings.collect += clock.lap("collect");
+        runKernel(R, full, pingPong[next], workspace, options, displs[rank]);
+        R = pingPong[next];
+        next ^= 1;
+        timings.compute += clock.lap("compute", 2.0 * myRows * n * n);
+        if ((k >> bit) & 1) {
+            runKernel(R, fullA, pingPong[next], workspace, options, displs[rank]);
+            R = pingPong[next];
+            next ^= 1;
+            timings.compute += clock.lap("compute", 2.0 * myRows * n * n);
+        }
+    }
+
+    if (k == 1 && options.modulus != 0) {
+        // no product reduced the elements of A
+        const Modulus modulus(options.modulus);
+        Matrix reduced = pingPong[0];
+        for (std::size_t e = 0; e < R.storageSize(); ++e) {
+            reduced.data[e] = static_cast<int>(modulus.reduce(R.data[e]));
+        }
+        R = reduced;
+    }
+    if (rank == 0) {
+        std::copy(R.data, R.data + R.storageSize(), C.row(displs[0]));
+        MPI_Gatherv(MPI_IN_PLACE, myRows, row, C.data, counts, displs, row, 0, comm);
+    } else {
+        MPI_Gatherv(R.data, myRows, row, nullptr, counts, displs, row, 0, comm);
+    }
+    timings.collect += clock.lap("collect");
+    MPI_Type_free(&row);
+    return C;
+}
@@ -0,0 +1,81 @@
+#include "generator.h"
+#include "random.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+/**
+ * Uniform in [minValue, maxValue] from 64 random bits by multiply-shift (bias below 2^-31).
+ */
+int uniformValue(const GeneratorSpec& spec, std::uint64_t bits) {
+    const std::uint64_t span = static_cast<std::uint64_t>(static_cast<std::int64_t>(spec.maxValue) - spec.minValue) + 1;
+    const std::uint64_t offset = static_cast<std::uint64_t>((static_cast<unsigned __int128>(bits) * span) >> 64);
+    return static_cast<int>(spec.minValue + static_cast<std::int64_t>(offset));
+}
+
+int randomValue(const GeneratorSpec& spec, int i, int j) {
+    return uniformValue(spec, counterRandom(spec.seed, static_cast<std::uint64_t>(i) * static_cast<std::uint64_t>(spec.cols) + j));
+}
+
+}
+
+bool parseMatrixKind(const char* name, MatrixKind& kind) {
+    static const struct {
+        const char* name;
+        MatrixKind kind;
+    } kinds[] = {
+        {"random", MatrixKind::Random},
+        {"sparse", MatrixKind::Sparse},
+        {"banded", MatrixKind::Banded},
+        {"identity", MatrixKind::Identity},
+        {"diagonal", MatrixKind::Diagonal},
+        {"symmetric", MatrixKind::Symmetric},
+        {"lower", MatrixKind::LowerTriangular},
+        {"upper", MatrixKind::UpperTriangular},
+    };
+    for (const auto& entry : kinds) {
+        if (std::strcmp(name, entry.name) == 0) {
+            kind = entry.kind;
+            return true;
+        }
+    }
+    return false;
+}
+
+int generateElement(const GeneratorSpec& spec, int i, int j) {
+    switch (spec.kind) {
+    case MatrixKind::Random:
+        return randomValue(spec, i, j);
+    case MatrixKind::Sparse: {
+        // one draw decides whether the element is present, an independent one gives its value
+        const std::uint64_t index = static_cast<std::uint64_t>(i) * static_cast<std::uint64_t>(spec.cols) + j;
+        const double u = static_cast<double>(counterRandom(streamSeed(spec.seed, 1), index) >> 11) * 0x1.0p-53;
+        return u < spec.density ? randomValue(spec, i, j) : 0;
+    }
+    case MatrixKind::Banded:
+        return j - i >= -spec.lowerBandwidth && j - i <= spec.upperBandwidth ? randomValue(spec, i, j) : 0;
+    case MatrixKind::Identity:
+        return i == j ? 1 : 0;
+    case MatrixKind::Diagonal:
+        return i == j ? randomValue(spec, i, j) : 0;
+    case MatrixKind::Symmetric:
+        return randomValue(spec, std::min(i, j), std::max(i, j));
+    case MatrixKind::LowerTriangular:
+        return j <= i ? randomValue(spec, i, j) : 0;
+    case MatrixKind::UpperTriangular:
+        return j >= i ? randomValue(spec, i, j) : 0;
+    }
+    return 0;
+}
+
+void generateRows(const GeneratorSpec& spec, int firstRow, Matrix& block) {
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < block.rows; ++i) {
+        int* r = block.row(i);
+        for (int j = 0; j < block.cols; ++j) {
+            r[j] = generateElement(spec, firstRow + i, j);
+        }
+        std::fill(r + block.cols, r + block.stride, 0);
+    }
+}
@@ -0,0 +1,122 @@
+#include "hash.h"
+#include <cstring>
+
+namespace {
+
+constexpr std::uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+constexpr std::uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr std::uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+constexpr std::uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+constexpr std::uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+inline std::uint64_t rotl(std::uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+inline std::uint64_t read64(const unsigned char* p) {
+    std::uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline std::uint32_t read32(const unsigned char* p) {
+    std::uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline std::uint64_t round(std::uint64_t acc, std::uint64_t input) {
+    acc += input * kPrime2;
+    acc = rotl(acc, 31);
+    return acc * kPrime1;
+}
+
+inline std::uint64_t mergeRound(std::uint64_t acc, std::uint64_t val) {
+    acc ^= round(0, val);
+    return acc * kPrime1 + kPrime4;
+}
+
+}
+
+Hash64::Hash64(std::uint64_t seed) : seed_(seed) {
+    acc_[0] = seed + kPrime1 + kPrime2;
+    acc_[1] = seed + kPrime2;
+    acc_[2] = seed;
+    acc_[3] = seed - kPrime1;
+}
+
+void Hash64::update(const void* data, std::size_t bytes) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    const unsigned char* const end = p + bytes;
+    total_ += bytes;
+
+    if (buffered_ + bytes < 32) {
+        std::memcpy(buffer_ + buffered_, p, bytes);
+        buffered_ += bytes;
+        return;
+    }
+    if (buffered_ > 0) {
+        const std::size_t fill = 32 - buffered_;
+        std::memcpy(buffer_ + buffered_, p, fill);
+        for (int lane = 0; lane < 4; ++lane) {
+            acc_[lane] = round(acc_[lane], read64(buffer_ + 8 * lane));
+        }
+        p += fill;
+        buffered_ = 0;
+    }
+    while (end - p >= 32) {
+        for (int lane = 0; lane < 4; ++lane) {
+            acc_[lane] = round(acc_[lane], read64(p + 8 * lane));
+        }
+        p += 32;
+    }
+    buffered_ = static_cast<std::size_t>(end - p);
+    std::memcpy(buffer_, p, buffered_);
+}
+
+std::uint64_t Hash64::digest() const {
+    std::uint64_t h;
+    if (total_ >= 32) {
+        h = rotl(acc_[0], 1) + rotl(acc_[1], 7) + rotl(acc_[2], 12) + rotl(acc_[3], 18);
+        for (int lane = 0; lane < 4; ++lane) {
+            h = mergeRound(h, acc_[lane]);
+        }
+    } else {
+        h = seed_ + kPrime5;
+    }
+    h += total_;
+
+    const unsigned char* p = buffer_;
+    std::size_t left = buffered_;
+    while (left >= 8) {
+        h ^= round(0, read64(p));
+        h = rotl(h, 27) * kPrime1 + kPrime4;
+        p += 8;
+        left -= 8;
+    }
+    if (left >= 4) {
+        h ^= static_cast<std::uint64_t>(read32(p)) * kPrime1;
+        h = rotl(h, 23) * kPrime2 + kPrime3;
+        p += 4;
+        left -= 4;
+    }
+    while (left > 0) {
+        h ^= (*p) * kPrime5;
+        h = rotl(h, 11) * kPrime1;
+        ++p;
+        --left;
+    }
+
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+std::uint64_t hash64(const void* data, std::size_t bytes, std::uint64_t seed) {
+    Hash64 hash(seed);
+    hash.update(data, bytes);
+    return hash.digest();
+}
@@ -0,0 +1,257 @@
+#include "kernel_registry.h"
+#include "generator.h"
+#include "kernels.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <ostream>
+
+namespace {
+
+std::string readCpuModel() {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.compare(0, 10, "model name") == 0) {
+            const std::size_t colon = line.find(':');
+            if (colon != std::string::npos) {
+                std::string model = line.substr(colon + 1);
+                model.erase(0, model.find_first_not_of(" \t"));
+                std::replace(model.begin(), model.end(), '\t', ' ');
+                return model;
+            }
+        }
+    }
+    return "unknown";
+}
+
+int log2Bucket(int x) {
+    int bucket = 0;
+    while ((1 << bucket) < x && bucket < 30) {
+        ++bucket;
+    }
+    return bucket;
+}
+
+const char* widthName(QuantizedWidth width) {
+    switch (width) {
+    case QuantizedWidth::Int8:
+        return "int8";
+    case QuantizedWidth::Int16:
+        return "int16";
+    default:
+        return "int32";
+    }
+}
+
+std::string blockedName(const char* kernel, const BlockSizes& b, bool unrolled) {
+    return std::string(kernel) + " mc=" + std::to_string(b.mc) + " kc=" + std::to_string(b.kc) +
+           " nc=" + std::to_string(b.nc) + (unrolled ? " mr=" + std::to_string(b.mr) : "");
+}
+
+BlockSizes blockSizes(int mc, int kc, int nc, int mr) {
+    BlockSizes b;
+    b.mc = mc;
+    b.kc = kc;
+    b.nc = nc;
+    b.mr = mr;
+    return b;
+}
+
+}
+
+KernelRegistry::KernelRegistry() : cpuModel_(readCpuModel()) {
+    add({"naive", QuantizedWidth::Int32,
+         [](const Matrix& A, const Matrix& B, Matrix& C, Arena&) { multiplyNaive(A, B, C); }});
+    for (const BlockSizes& b : {blockSizes(64, 256, 1024, 1), blockSizes(64, 256, 1024, 4),
+                                blockSizes(128, 128, 512, 4), blockSizes(32, 512, 2048, 2)}) {
+        add({blockedName("blocked", b, true), QuantizedWidth::Int32,
+             [b](const Matrix& A, const Matrix& B, Matrix& C, Arena& w) { multiplyBlocked(A, B, C, w, b); }});
+    }
+    for (int threshold : {128, 256}) {
+        const BlockSizes b = blockSizes(64, 256, 1024, 4);
+        add({"strassen threshold=" + std::to_string(threshold), QuantizedWidth::Int32,
+             [threshold, b](const Matrix& A, const Matrix& B, Matrix& C, Arena& w) {
+                 multiplyStrassen(A, B, C, w, threshold, b);
+             }});
+    }
+    for (const BlockSizes& b : {BlockSizes(), blockSizes(64, 512, 1024, 1)}) {
+        add({blockedName("int16", b, false), QuantizedWidth::Int16,
+             [b](const Matrix& A, const Matrix& B, Matrix& C, Arena& w) { multiplyInt16(A, B, C, w, b); }});
+        add({blockedName("int8", b, false), QuantizedWidth::Int8,
+             [b](const Matrix& A, const Matrix& B, Matrix& C, Arena& w) { multiplyInt8(A, B, C, w, b); }});
+    }
+}
+
+void KernelRegistry::add(KernelVariant variant) {
+    variants_.push_back(std::move(variant));
+}
+
+const KernelVariant* KernelRegistry::find(const std::string& name) const {
+    for (const KernelVariant& v : variants_) {
+        if (v.name == name) {
+            return &v;
+        }
+    }
+    return nullptr;
+}
+
+std::string KernelRegistry::shapeClass(int m, int k, int n, QuantizedWidth width) {
+    return std::string(widthName(width)) + " m" + std::to_string(log2Bucket(m)) +
+           " k" + std::to_string(log2Bucket(k)) + " n" + std::to_string(log2Bucket(n));
+}
+
+bool KernelRegistry::load(const std::string& path) {
+    table_.clear();
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        const std::size_t second = line.rfind('\t');
+        if (line.empty() || line[0] == '#' || second == std::string::npos || line.find('\t') == second) {
+            continue;
+        }
+        table_[line.substr(0, second)] = line.substr(second + 1);
+    }
+    changed_ = false;
+    return true;
+}
+
+bool KernelRegistry::save(const std::string& path) const {
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary);
+        out << "# cpu model\tshape class\tkernel variant\n";
+        for (const auto& entry : table_) {
+            out << entry.first << '\t' << entry.second << '\n';
+        }
+        if (!out.flush()) {
+            return false;
+        }
+    }
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+bool KernelRegistry::hasEntry(int m, int k, int n, QuantizedWidth width) const {
+    const auto it = table_.find(cpuModel_ + '\t' + shapeClass(m, k, n, width));
+    return it != table_.end() && find(it->second) != nullptr;
+}
+
+const KernelVariant* KernelRegistry::nearest(int m, int k, int n, QuantizedWidth width) const {
+    const std::string prefix = cpuModel_ + '\t' + widthName(width) + ' ';
+    const KernelVariant* best = nullptr;
+    int bestDistance = 0;
+    for (auto it = table_.lower_bound(prefix); it != table_.end() && it->first.compare(0, prefix.size(), prefix) == 0;
+         ++it) {
+        int bm, bk, bn;
+        const KernelVariant* variant = find(it->second);
+        if (variant == nullptr || width > variant->width ||
+            std::sscanf(it->first.c_str() + prefix.size(), "m%d k%d n%d", &bm, &bk, &bn) != 3) {
+            continue;
+        }
+        const int distance = std::abs(bm - log2Bucket(m)) + std::abs(bk - log2Bucket(k)) + std::abs(bn - log2Bucket(n));
+        if (best == nullptr || distance < bestDistance) {
+            best = variant;
+            bestDistance = distance;
+        }
+    }
+    return best;
+}
+
+const KernelVariant* KernelRegistry::select(int m, int k, int n, QuantizedWidth width, Arena& workspace) {
+    const auto it = table_.find(cpuModel_ + '\t' + shapeClass(m, k, n, width));
+    if (it != table_.end()) {
+        const KernelVariant* variant = find(it->second);
+        if (variant != nullptr && width <= variant->width) {
+            ++lookups_.exact;
+            return variant;
+        }
+    }
+    if (tuneOnMiss_) {
+        ++lookups_.exact;
+        return &tune(m, k, n, width, workspace);
+    }
+    const KernelVariant* variant = nearest(m, k, n, width);
+    ++(variant != nullptr ? lookups_.nearest : lookups_.misses);
+    return variant;
+}
+
+const KernelVariant& KernelRegistry::tune(int m, int k, int n, QuantizedWidth width, Arena& workspace) {
+    Arena::Scope scratch(workspace);
+    GeneratorSpec spec;
+    switch (width) {
+    case QuantizedWidth::Int8:
+        spec.minValue = std::numeric_limits<std::int8_t>::min();
+        spec.maxValue = std::numeric_limits<std::int8_t>::max();
+        break;
+    case QuantizedWidth::Int16:
+        spec.minValue = std::numeric_limits<std::int16_t>::min();
+        spec.maxValue = std::numeric_limits<std::int16_t>::max();
+        break;
+    default:
+        spec.minValue = std::numeric_limits<int>::min();
+        spec.maxValue = std::numeric_limits<int>::max();
+        break;
+    }
+    const int tuneK = std::max(1, std::min(k, kTuneMaxDimension));
+    const int tuneN = std::max(1, std::min(n, kTuneMaxDimension));
+    const int tuneM = static_cast<int>(std::max(1LL, std::min<long long>(m, kTuneMaxWork / tuneK / tuneN)));
+    auto operand = [&](int rows, int cols, std::uint64_t seed) {
+        spec.rows = rows;
+        spec.cols = cols;
+        spec.seed = seed;
+        Matrix M = allocateMatrix(workspace, spec.rows, spec.cols);
+        generateRows(spec, 0, M);
+        return M;
+    };
+    const Matrix A = operand(tuneM, tuneK, 1);
+    const Matrix B = operand(tuneK, tuneN, 2);
+    Matrix reference = allocateMatrix(workspace, A.rows, B.cols);
+    Matrix C = allocateMatrix(workspace, A.rows, B.cols);
+    multiplyBlocked(A, B, reference, workspace);
+
+    const std::string shape = shapeClass(m, k, n, width);
+    const KernelVariant* best = nullptr;
+    double bestSeconds = 0;
+    if (log_ != nullptr) {
+        *log_ << "autotune " << shape << " at " << tuneM << "x" << tuneK << "x" << tuneN << " on " << cpuModel_ << ":";
+    }
+    for (const KernelVariant& variant : variants_) {
+        if (width > variant.width) {
+            continue;
+        }
+        // best of two runs, the first one also warms the workspace
+        double seconds = 0;
+        for (int run = 0; run < 2; ++run) {
+            const auto start = std::chrono::steady_clock::now();
+            variant.run(A, B, C, workspace);
+            const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            seconds = run == 0 ? elapsed : std::min(seconds, elapsed);
+        }
+        bool exact = true;
+        for (int i = 0; i < C.rows && exact; ++i) {
+            exact = std::equal(C.row(i), C.row(i) + C.cols, reference.row(i));
+        }
+        if (log_ != nullptr) {
+            *log_ << " [" << variant.name << "] " << seconds << " s" << (exact ? "" : " (wrong result)");
+        }
+        if (exact && (best == nullptr || seconds < bestSeconds)) {
+            best = &variant;
+            bestSeconds = seconds;
+        }
+    }
+    if (best == nullptr) {
+        best = find(blockedName("blocked", BlockSizes(), true));
+    }
+    if (log_ != nullptr) {
+        *log_ << " -> " << best->name << std::endl;
+    }
+    table_[cpuModel_ + '\t' + shape] = best->name;
+    changed_ = true;
+    return *best;
+}
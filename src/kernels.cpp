@@ -0,0 +1,399 @@
+#include "kernels.h"
+#include "kernel_registry.h"
+#include "quantized.h"
+#include "structure.h"
+#include "vector_kernels.h"
+#include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+
+/**
+ * Copy op(B)[k0:k0+kc, j0:j0+nc] into a contiguous kc x nc panel, op(B) being B or B^T.
+ */
+void packPanel(const Matrix& B, bool transB, int k0, int kc, int j0, int nc, int* panel) {
+    if (!transB) {
+        for (int k = 0; k < kc; ++k) {
+            const int* src = B.row(k0 + k) + j0;
+            std::copy(src, src + nc, panel + static_cast<std::size_t>(k) * nc);
+        }
+        return;
+    }
+    for (int j = 0; j < nc; ++j) {
+        const int* src = B.row(j0 + j) + k0;
+        for (int k = 0; k < kc; ++k) {
+            panel[static_cast<std::size_t>(k) * nc + j] = src[k];
+        }
+    }
+}
+
+/**
+ * Copy alpha * op(A)[i0:i0+mc, k0:k0+kc] into a contiguous mc x kc block, op(A) being A or A^T.
+ */
+void packBlock(const Matrix& A, bool transA, int alpha, int i0, int mc, int k0, int kc, int* block) {
+    for (int i = 0; i < mc; ++i) {
+        int* dst = block + static_cast<std::size_t>(i) * kc;
+        for (int k = 0; k < kc; ++k) {
+            const int a = transA ? A.at(k0 + k, i0 + i) : A.at(i0 + i, k0 + k);
+            dst[k] = static_cast<int>(static_cast<unsigned>(alpha) * static_cast<unsigned>(a));
+        }
+    }
+}
+
+/**
+ * c[0:mc, 0:nc] += a[0:mc, 0:kc] * panel, a and c being row-major with leading
+ * dimensions lda and ldc.
+ * MR rows of C are updated together so that every row of the panel loaded from cache
+ * feeds MR accumulators.
+ */
+template <int MR>
+void multiplyPanel(const int* a, std::size_t lda, const int* panel, int* c, std::size_t ldc,
+                   int mc, int kc, int nc) {
+    int i = 0;
+    for (; i + MR <= mc; i += MR) {
+        const int* ar[MR];
+        int* cr[MR];
+        for (int r = 0; r < MR; ++r) {
+            ar[r] = a + (i + r) * lda;
+            cr[r] = c + (i + r) * ldc;
+        }
+        for (int k = 0; k < kc; ++k) {
+            const int* b = panel + static_cast<std::size_t>(k) * nc;
+            for (int r = 0; r < MR; ++r) {
+                const int aik = ar[r][k];
+                int* crow = cr[r];
+#pragma omp simd
+                for (int j = 0; j < nc; ++j) {
+                    crow[j] += aik * b[j];
+                }
+            }
+        }
+    }
+    if (MR > 1 && i < mc) {
+        multiplyPanel<1>(a + i * lda, lda, panel, c + i * ldc, ldc, mc - i, kc, nc);
+    }
+}
+
+void multiplyPanelUnrolled(int mr, const int* a, std::size_t lda, const int* panel, int* c, std::size_t ldc,
+                           int mc, int kc, int nc) {
+    switch (mr) {
+    case 4:
+        multiplyPanel<4>(a, lda, panel, c, ldc, mc, kc, nc);
+        break;
+    case 2:
+        multiplyPanel<2>(a, lda, panel, c, ldc, mc, kc, nc);
+        break;
+    default:
+        multiplyPanel<1>(a, lda, panel, c, ldc, mc, kc, nc);
+        break;
+    }
+}
+
+/**
+ * C = A + sign * B on views (modulo 2^32, like the kernels).
+ */
+void addViews(const Matrix& A, const Matrix& B, Matrix& C, int sign) {
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < C.rows; ++i) {
+        const int* a = A.row(i);
+        const int* b = B.row(i);
+        int* c = C.row(i);
+#pragma omp simd
+        for (int j = 0; j < C.cols; ++j) {
+            c[j] = static_cast<int>(static_cast<unsigned>(a[j]) + static_cast<unsigned>(sign) * static_cast<unsigned>(b[j]));
+        }
+    }
+}
+
+/**
+ * Quadrant (qi, qj) of a matrix whose dimensions are even, sharing its storage.
+ */
+Matrix quadrant(const Matrix& M, int qi, int qj) {
+    Matrix q = M;
+    q.rows = M.rows / 2;
+    q.cols = M.cols / 2;
+    q.data = M.data + static_cast<std::size_t>(qi * q.rows) * M.stride + qj * q.cols;
+    q.padded = false;
+    return q;
+}
+
+/**
+ * Strassen recursion on views whose dimensions are multiples of 2^levels.
+ */
+void strassen(const Matrix& A, const Matrix& B, Matrix& C, Arena& workspace, int levels, const BlockSizes& blocks) {
+    if (levels == 0) {
+        multiplyBlocked(A, B, C, workspace, blocks);
+        return;
+    }
+    Arena::Scope scratch(workspace);
+    const Matrix A11 = quadrant(A, 0, 0), A12 = quadrant(A, 0, 1), A21 = quadrant(A, 1, 0), A22 = quadrant(A, 1, 1);
+    const Matrix B11 = quadrant(B, 0, 0), B12 = quadrant(B, 0, 1), B21 = quadrant(B, 1, 0), B22 = quadrant(B, 1, 1);
+    Matrix C11 = quadrant(C, 0, 0), C12 = quadrant(C, 0, 1), C21 = quadrant(C, 1, 0), C22 = quadrant(C, 1, 1);
+    Matrix S = allocateMatrix(workspace, A11.rows, A11.cols);
+    Matrix T = allocateMatrix(workspace, B11.rows, B11.cols);
+    Matrix M[7];
+    for (Matrix& m : M) {
+        m = allocateMatrix(workspace, C11.rows, C11.cols);
+    }
+
+    addViews(A11, A22, S, 1);
+    addViews(B11, B22, T, 1);
+    strassen(S, T, M[0], workspace, levels - 1, blocks);      // (A11 + A22)(B11 + B22)
+    addViews(A21, A22, S, 1);
+    strassen(S, B11, M[1], workspace, levels - 1, blocks);    // (A21 + A22) B11
+    addViews(B12, B22, T, -1);
+    strassen(A11, T, M[2], workspace, levels - 1, blocks);    // A11 (B12 - B22)
+    addViews(B21, B11, T, -1);
+    strassen(A22, T, M[3], workspace, levels - 1, blocks);    // A22 (B21 - B11)
+    addViews(A11, A12, S, 1);
+    strassen(S, B22, M[4], workspace, levels - 1, blocks);    // (A11 + A12) B22
+    addViews(A21, A11, S, -1);
+    addViews(B11, B12, T, 1);
+    strassen(S, T, M[5], workspace, levels - 1, blocks);      // (A21 - A11)(B11 + B12)
+    addViews(A12, A22, S, -1);
+    addViews(B21, B22, T, 1);
+    strassen(S, T, M[6], workspace, levels - 1, blocks);      // (A12 - A22)(B21 + B22)
+
+    addViews(M[0], M[3], C11, 1);
+    addViews(C11, M[4], C11, -1);
+    addViews(C11, M[6], C11, 1);
+    addViews(M[2], M[4], C12, 1);
+    addViews(M[1], M[3], C21, 1);
+    addViews(M[0], M[1], C22, -1);
+    addViews(C22, M[2], C22, 1);
+    addViews(C22, M[5], C22, 1);
+}
+
+}
+
+void gemm(Transpose transA, Transpose transB, int alpha, const Matrix& A, const Matrix& B,
+          int beta, Matrix& C, Arena& workspace, const BlockSizes& blocks) {
+    GemmTerm term;
+    term.transA = transA;
+    term.transB = transB;
+    term.alpha = alpha;
+    term.A = A;
+    term.B = B;
+    gemmFused(&term, 1, beta, C, workspace, blocks);
+}
+
+void gemmFused(const GemmTerm* terms, int count, int beta, Matrix& C, Arena& workspace,
+               const BlockSizes& blocks, const TileEpilogue& epilogue) {
+    const int m = C.rows, n = C.cols;
+    // op(A) goes through a packed block when it has to be transposed or scaled
+    int maxDepth = 0, last = -1;
+    bool packAny = false;
+    for (int t = 0; t < count; ++t) {
+        const int depth = terms[t].transA == Transpose::Yes ? terms[t].A.rows : terms[t].A.cols;
+        maxDepth = std::max(maxDepth, depth);
+        packAny = packAny || terms[t].transA == Transpose::Yes || terms[t].alpha != 1;
+        if (terms[t].alpha != 0 && depth > 0) {
+            last = t;  // the tiles of C are final after its last k block
+        }
+    }
+    int maxThreads = 1;
+#ifdef _OPENMP
+    maxThreads = omp_get_max_threads();
+#endif
+
+    // one panel (and block of A) per thread, carved out here because the arena is not thread safe;
+    // each thread packs (first touches) its own panel so it lands on the thread's NUMA node
+    Arena::Scope scratch(workspace);
+    const int kc0 = std::max(std::min(blocks.kc, maxDepth), 1);
+    const std::size_t panelSize = static_cast<std::size_t>(kc0) * std::max(std::min(blocks.nc, n), 1);
+    const std::size_t blockSize = packAny ? static_cast<std::size_t>(kc0) * std::max(std::min(blocks.mc, m), 1) : 0;
+    int* panels = workspace.allocateArray<int>(panelSize * maxThreads);
+    int* packedBlocks = packAny ? workspace.allocateArray<int>(blockSize * maxThreads) : nullptr;
+
+#pragma omp parallel num_threads(maxThreads)
+    {
+        int threads = 1, tid = 0;
+#ifdef _OPENMP
+        threads = omp_get_num_threads();
+        tid = omp_get_thread_num();
+#endif
+        // static row partition: the thread that zeroes a row of C is the one that computes it
+        int begin, end;
+        blockRange(m, threads, tid, begin, end);
+        if (beta == 0) {
+            // C is not read at all, padding included
+            Matrix myC = rowBlock(C, begin, end - begin);
+            fillMatrix(myC, 0);
+        } else if (beta != 1) {
+            for (int i = begin; i < end; ++i) {
+                int* c = C.row(i);
+#pragma omp simd
+                for (int j = 0; j < n; ++j) {
+                    c[j] = static_cast<int>(static_cast<unsigned>(beta) * static_cast<unsigned>(c[j]));
+                }
+            }
+        }
+        int* panel = panels + panelSize * tid;
+        int* block = packedBlocks + blockSize * tid;
+
+        for (int j0 = 0; begin < end && j0 < n; j0 += blocks.nc) {
+            const int nc = std::min(blocks.nc, n - j0);
+            for (int t = 0; t <= last; ++t) {
+                const GemmTerm& term = terms[t];
+                const bool ta = term.transA == Transpose::Yes, tb = term.transB == Transpose::Yes;
+                const bool packA = ta || term.alpha != 1;
+                const int depth = ta ? term.A.rows : term.A.cols;
+                for (int k0 = 0; term.alpha != 0 && k0 < depth; k0 += blocks.kc) {
+                    const int kc = std::min(blocks.kc, depth - k0);
+                    const bool lastBlock = t == last && k0 + kc == depth;
+                    packPanel(term.B, tb, k0, kc, j0, nc, panel);
+                    for (int i0 = begin; i0 < end; i0 += blocks.mc) {
+                        const int mc = std::min(blocks.mc, end - i0);
+                        int* c = C.row(i0) + j0;
+                        if (packA) {
+                            packBlock(term.A, ta, term.alpha, i0, mc, k0, kc, block);
+                            multiplyPanelUnrolled(blocks.mr, block, kc, panel, c, C.stride, mc, kc, nc);
+                        } else {
+                            multiplyPanelUnrolled(blocks.mr, term.A.row(i0) + k0, term.A.stride, panel,
+                                                  c, C.stride, mc, kc, nc);
+                        }
+                        if (lastBlock && epilogue.apply != nullptr) {
+                            epilogue.apply(epilogue.context, c, C.stride, i0, j0, mc, nc);
+                        }
+                    }
+                }
+            }
+            if (last < 0 && epilogue.apply != nullptr) {
+                // nothing to accumulate: the epilogue still sees beta * C
+                epilogue.apply(epilogue.context, C.row(begin) + j0, C.stride, begin, j0, end - begin, nc);
+            }
+        }
+    }
+}
+
+void multiplyBlocked(const Matrix& A, const Matrix& B, Matrix& C, Arena& workspace,
+                     const BlockSizes& blocks) {
+    gemm(Transpose::No, Transpose::No, 1, A, B, 0, C, workspace, blocks);
+}
+
+void multiplyNaive(const Matrix& A, const Matrix& B, Matrix& C) {
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < A.rows; ++i) {
+        int* c = C.row(i);
+        std::fill(c, c + C.span(), 0);
+        const int* a = A.row(i);
+        for (int k = 0; k < A.cols; ++k) {
+            const int aik = a[k];
+            const int* b = B.row(k);
+#pragma omp simd
+            for (int j = 0; j < B.cols; ++j) {
+                c[j] += aik * b[j];
+            }
+        }
+    }
+}
+
+void multiplyStrassen(const Matrix& A, const Matrix& B, Matrix& C, Arena& workspace,
+                      int threshold, const BlockSizes& blocks) {
+    int levels = 0;
+    while (std::min({A.rows, A.cols, B.cols}) >> levels > threshold) {
+        ++levels;
+    }
+    if (levels == 0) {
+        multiplyBlocked(A, B, C, workspace, blocks);
+        return;
+    }
+    // zero padding up to multiples of 2^levels, so that every quadrant split is exact
+    Arena::Scope scratch(workspace);
+    const int unit = 1 << levels;
+    auto padded = [&](const Matrix& M) {
+        Matrix P = allocateMatrix(workspace, (M.rows + unit - 1) / unit * unit, (M.cols + unit - 1) / unit * unit);
+        fillMatrix(P, 0);
+        for (int i = 0; i < M.rows; ++i) {
+            std::copy(M.row(i), M.row(i) + M.cols, P.row(i));
+        }
+        return P;
+    };
+    const Matrix PA = padded(A);
+    const Matrix PB = padded(B);
+    Matrix PC = allocateMatrix(workspace, PA.rows, PB.cols);
+    strassen(PA, PB, PC, workspace, levels, blocks);
+    for (int i = 0; i < C.rows; ++i) {
+        std::copy(PC.row(i), PC.row(i) + C.cols, C.row(i));
+        std::fill(C.row(i) + C.cols, C.row(i) + C.span(), 0);
+    }
+}
+
+void multiplyPower(const Matrix& A, int k, Matrix& C, Arena& workspace) {
+    if (k <= 1) {
+        fillMatrix(C, 0);
+        for (int i = 0; i < A.rows; ++i) {
+            if (k == 1) {
+                std::copy(A.row(i), A.row(i) + A.cols, C.row(i));
+            } else {
+                C.at(i, i) = 1;
+            }
+        }
+        return;
+    }
+    int bit = 30;
+    while (!((k >> bit) & 1)) {
+        --bit;
+    }
+    const int products = bit + __builtin_popcount(k) - 1;
+
+    // the products alternate between C and T, starting so that the last one lands in C
+    Arena::Scope scratch(workspace);
+    Matrix T = allocateMatrix(workspace, A.rows, A.cols);
+    Matrix pingPong[2] = {products % 2 == 1 ? C : T, products % 2 == 1 ? T : C};
+    Matrix R = A;
+    int next = 0;
+    for (--bit; bit >= 0; --bit) {
+        multiplyAuto(R, R, pingPong[next], workspace);
+        R = pingPong[next];
+        next ^= 1;
+        if ((k >> bit) & 1) {
+            multiplyAuto(R, A, pingPong[next], workspace);
+            R = pingPong[next];
+            next ^= 1;
+        }
+    }
+}
+
+void multiplyAuto(const Matrix& A, const Matrix& B, Matrix& C, Arena& workspace,
+                  KernelReport* report, int rowOffsetA, KernelRegistry* registry) {
+    const MatrixStructure sa = detectStructure(A, rowOffsetA);
+    const MatrixStructure sb = detectStructure(B);
+
+    const char* kernel = multiplyStructured(A, B, C, sa, sb);
+    if (kernel == nullptr) {
+        kernel = multiplyVectorShape(A, B, C, workspace);
+    }
+    const QuantizedWidth width = quantizedWidth(sa.range, sb.range);
+    if (kernel == nullptr && registry != nullptr) {
+        if (const KernelVariant* variant = registry->select(A.rows, A.cols, B.cols, width, workspace)) {
+            variant->run(A, B, C, workspace);
+            kernel = variant->name.c_str();
+        }
+    }
+    if (kernel == nullptr) {
+        switch (width) {
+        case QuantizedWidth::Int8:
+            multiplyInt8(A, B, C, workspace);
+            kernel = "int8";
+            break;
+        case QuantizedWidth::Int16:
+            multiplyInt16(A, B, C, workspace);
+            kernel = "int16";
+            break;
+        default:
+            gemm(Transpose::No, Transpose::No, 1, A, B, 0, C, workspace);
+            kernel = "blocked";
+            break;
+        }
+    }
+
+    if (report != nullptr) {
+        report->kernel = kernel;
+        report->structureA = describeStructure(sa, A.cols);
+        report->structureB = describeStructure(sb, B.cols);
+        report->detectSeconds = sa.seconds + sb.seconds;
+    }
+}
@@ -1,84 +1,481 @@
-#include "matrix_multiplication.h"
+#include "arena.h"
+#include "boolean.h"
+#include "checkpoint.h"
+#include "distributed.h"
+#include "kernel_registry.h"
+#include "matrix.h"
+#include "modular.h"
+#include "perf_counters.h"
+#include "pipeline.h"
+#include "placement.h"
+#include "progress.h"
+#include "result_cache.h"
+#include "service.h"
+#include "verify.h"
 #include <mpi/mpi.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
-#include <fstream>
+#include <memory>
+#include <string>
 #include <vector>
 
-void readMatrixFromFile(const std::string& filename, std::vector<std::vector<int>>& matrix, int& rows, int& cols) {
-    std::ifstream infile(filename);
-    if (!infile) {
+struct Options {
+    bool hugePages = false;
+    bool arenaStats = false;
+    bool pin = true;
+    bool placement = false;
+    std::string cacheDirectory;  // empty: no result cache
+    std::uint64_t cacheMaxBytes = std::uint64_t(1) << 30;
+    std::string serveSocket;     // non empty: run as a service on this Unix socket
+    std::string manifest;        // non empty: run every job of the manifest as a pipeline
+    int pipelineDepth = 3;
+    std::string checkpointDirectory; // non empty: checkpoint the tiles of C in this directory
+    double checkpointInterval = 30;
+    bool resume = false;
+    bool kernelReport = false;
+    bool timings = false;
+    bool sharedB = false;
+    bool oneSided = false;
+    bool dynamic = false;
+    bool verify = false;         // Freivalds' check of a computed C (not of cache hits)
+    int verifyRounds = 10;
+    bool perfCounters = false;
+    std::string tuningFile;      // non empty: dispatch the general case to the variants tuned in this file
+    bool autotune = false;       // re-tune the shape class of this run even if the file has it
+    std::uint64_t modulus = 0;   // non zero: C = A * B mod modulus
+    bool boolean = false;        // 0/1 operands, Boolean product (see boolean.h)
+    std::string semiring = "plus-times";  // see semiring.h
+    bool powerMode = false;      // C = A^power, matrixB.txt is not read
+    int power = 0;
+    bool progressThread = false; // a thread owns the point-to-point transfers (see progress.h)
+};
+
+Options parseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--huge-pages") == 0) {
+            options.hugePages = true;
+        } else if (std::strcmp(argv[i], "--arena-stats") == 0) {
+            options.arenaStats = true;
+        } else if (std::strcmp(argv[i], "--no-pin") == 0) {
+            options.pin = false;
+        } else if (std::strcmp(argv[i], "--placement") == 0) {
+            options.placement = true;
+        } else if (std::strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            options.cacheDirectory = argv[++i];
+        } else if (std::strcmp(argv[i], "--cache-max-bytes") == 0 && i + 1 < argc) {
+            options.cacheMaxBytes = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+            options.serveSocket = argv[++i];
+        } else if (std::strcmp(argv[i], "--manifest") == 0 && i + 1 < argc) {
+            options.manifest = argv[++i];
+        } else if (std::strcmp(argv[i], "--pipeline-depth") == 0 && i + 1 < argc) {
+            options.pipelineDepth = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+            options.checkpointDirectory = argv[++i];
+        } else if (std::strcmp(argv[i], "--checkpoint-interval") == 0 && i + 1 < argc) {
+            options.checkpointInterval = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--resume") == 0) {
+            options.resume = true;
+        } else if (std::strcmp(argv[i], "--kernel-report") == 0) {
+            options.kernelReport = true;
+        } else if (std::strcmp(argv[i], "--timings") == 0) {
+            options.timings = true;
+        } else if (std::strcmp(argv[i], "--shared-b") == 0) {
+            options.sharedB = true;
+        } else if (std::strcmp(argv[i], "--one-sided") == 0) {
+            options.oneSided = true;
+        } else if (std::strcmp(argv[i], "--dynamic") == 0) {
+            options.dynamic = true;
+        } else if (std::strcmp(argv[i], "--verify") == 0) {
+            options.verify = true;
+        } else if (std::strcmp(argv[i], "--verify-rounds") == 0 && i + 1 < argc) {
+            options.verifyRounds = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--perf-counters") == 0) {
+            options.perfCounters = true;
+        } else if (std::strcmp(argv[i], "--tuning") == 0 && i + 1 < argc) {
+            options.tuningFile = argv[++i];
+        } else if (std::strcmp(argv[i], "--autotune") == 0) {
+            options.autotune = true;
+        } else if (std::strcmp(argv[i], "--modulus") == 0 && i + 1 < argc) {
+            options.modulus = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--boolean") == 0) {
+            options.boolean = true;
+        } else if (std::strcmp(argv[i], "--semiring") == 0 && i + 1 < argc) {
+            options.semiring = argv[++i];
+        } else if (std::strcmp(argv[i], "--power") == 0 && i + 1 < argc) {
+            options.powerMode = true;
+            options.power = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--progress-thread") == 0) {
+            options.progressThread = true;
+        }
+    }
+    return options;
+}
+
+void loadMatrix(const std::string& filename, Arena& arena, Matrix& matrix) {
+    if (!readMatrixFromFile(filename, arena, matrix)) {
         std::cerr << "Error opening file: " << filename << std::endl;
         MPI_Abort(MPI_COMM_WORLD, 1);
     }
-    
-    infile >> rows >> cols;
-    matrix.resize(rows, std::vector<int>(cols));
+}
+
+/**
+ * One line per run with the slowest rank of every phase, parsed by scaling.sh.
+ */
+void printTimings(MPI_Comm comm, int threads, double read, const PhaseTimes& phases, double write, double total) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    double local[6] = {read, phases.distribute, phases.compute, phases.collect, write, total};
+    double slowest[6];
+    MPI_Reduce(local, slowest, 6, MPI_DOUBLE, MPI_MAX, 0, comm);
+    if (rank == 0) {
+        std::cerr << "[timings] ranks=" << size << " threads=" << threads
+                  << " read=" << slowest[0] << " distribute=" << slowest[1] << " compute=" << slowest[2]
+                  << " collect=" << slowest[3] << " write=" << slowest[4] << " total=" << slowest[5] << std::endl;
+    }
+}
+
+/**
+ * Rank 0 tunes the shape classes of the blocks the ranks will multiply (row blocks, or the
+ * slices of the inner split when A has fewer rows than there are ranks, each with the width
+ * of its own values) that the tuning file does not have yet (all of them if asked to), saves
+ * the file and the other ranks reload it, so the whole run dispatches with the same table.
+ * Other pieces (checkpoint tiles, dynamic ranges, overlap chunks) use the nearest tuned class.
+ */
+void tuneAtStartup(KernelRegistry& registry, const Options& options, const Matrix& A, const Matrix& B,
+                   Arena& workspace) {
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    if (rank == 0) {
+        const bool splitK = A.rows < size;
+        const ValueRange rangeB = scanRange(B);
+        std::vector<std::string> tuned;
+        for (int r = 0; r < size; ++r) {
+            int begin, end;
+            blockRange(splitK ? A.cols : A.rows, size, r, begin, end);
+            if (begin == end) {
+                continue;
+            }
+            const Matrix a = splitK ? subMatrix(A, 0, begin, A.rows, end - begin) : rowBlock(A, begin, end - begin);
+            const QuantizedWidth width = quantizedWidth(scanRange(a), splitK ? scanRange(rowBlock(B, begin, end - begin))
+                                                                             : rangeB);
+            const std::string shape = KernelRegistry::shapeClass(a.rows, a.cols, B.cols, width);
+            if (std::find(tuned.begin(), tuned.end(), shape) != tuned.end() ||
+                (!options.autotune && registry.hasEntry(a.rows, a.cols, B.cols, width))) {
+                continue;
+            }
+            registry.setLog(&std::cerr);
+            registry.tune(a.rows, a.cols, B.cols, width, workspace);
+            registry.setLog(nullptr);
+            tuned.push_back(shape);
+        }
+        if (!tuned.empty() && !registry.save(options.tuningFile)) {
+            std::cerr << "Error writing file: " << options.tuningFile << std::endl;
+        }
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (rank != 0) {
+        registry.load(options.tuningFile);
+    }
+}
+
+/**
+ * Rank 0 aborts the job if A (rowsA x colsA) and B (rowsB x colsB) cannot be multiplied.
+ */
+void checkProductShape(int rowsA, int colsA, int rowsB, int colsB) {
+    if (colsA != rowsB) {
+        std::cerr << "Cannot multiply a " << rowsA << "x" << colsA << " matrixA.txt by a " << rowsB << "x" << colsB
+                  << " matrixB.txt" << std::endl;
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+}
 
-    for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
-            infile >> matrix[i][j];
+/**
+ * --boolean: the operands are read packed, multiplied with distributedMultiplyBoolean and
+ * printed as 0/1. The result cache, checkpoints and verification work on int matrices only.
+ */
+int runBoolean(const Options& options, int threads, Arena& storage) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    const double start = MPI_Wtime();
+    BitMatrix A, B;
+    if (rank == 0) {
+        if (!readBitMatrixFromFile("matrixA.txt", storage, A) || !readBitMatrixFromFile("matrixB.txt", storage, B)) {
+            std::cerr << "Error reading 0/1 matrices: matrixA.txt, matrixB.txt" << std::endl;
+            MPI_Abort(MPI_COMM_WORLD, 1);
         }
+        checkProductShape(A.rows, A.cols, B.rows, B.cols);
+    }
+    const double read = MPI_Wtime() - start;
+    PhaseTimes phases;
+    const BitMatrix C = distributedMultiplyBoolean(A, B, MPI_COMM_WORLD, storage, &phases);
+    double write = 0;
+    if (rank == 0) {
+        const double t = MPI_Wtime();
+        std::cout << "Congratulations, bro. Here is your resultant matrix C:" << std::endl;
+        writeBitMatrix(std::cout, C);
+        write = MPI_Wtime() - t;
+    }
+    if (options.timings) {
+        printTimings(MPI_COMM_WORLD, threads, read, phases, write, MPI_Wtime() - start);
+    }
+    return 0;
+}
+
+void printArenaStats(int rank, const char* name, const Arena& arena) {
+    const ArenaStats& s = arena.stats();
+    std::cerr << "[rank " << rank << "] arena " << name
+              << ": allocations=" << s.allocations
+              << " system_allocations=" << s.systemAllocations
+              << " system_frees=" << s.systemFrees
+              << " reserved_bytes=" << s.bytesReserved
+              << " high_water_bytes=" << s.highWater
+              << " huge_pages=" << (arena.hugePages() ? "yes" : "no") << std::endl;
+}
+
+/**
+ * Cpus of the progress thread next to the one of OpenMP thread 0, and a warning when the
+ * progress thread would poll on that cpu only (it would slow thread 0 down, not overlap).
+ */
+void reportProgressThread(std::ostream& out, int rank, const Placement& placement, const std::vector<int>& cpus) {
+    const int thread0 = placement.threadCpus.empty() ? -1 : placement.threadCpus[0];
+    out << "[rank " << rank << "] progress thread: cpus=";
+    for (std::size_t i = 0; i < cpus.size(); ++i) {
+        out << (i ? "," : "") << cpus[i];
+    }
+    out << " thread0=" << thread0 << std::endl;
+    if (cpus.size() == 1 && cpus[0] == thread0 && placement.cpus.size() > 1) {
+        out << "[rank " << rank << "] progress thread: WARNING confined to the cpu of OpenMP thread 0" << std::endl;
     }
 }
 
 int main(int argc, char** argv) {
-    MPI_Init(&argc, &argv);
+    // OpenMP threads and the pipeline stages never call MPI, only the main thread does,
+    // and the progress thread when there is one (parsed first: it needs MPI_THREAD_MULTIPLE)
+    const Options options = parseOptions(argc, argv);
+    int provided;
+    MPI_Init_thread(&argc, &argv, options.progressThread ? MPI_THREAD_MULTIPLE : MPI_THREAD_FUNNELED, &provided);
 
-    int rank, size;
+    int rank;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    MPI_Comm_size(MPI_COMM_WORLD, &size);
 
-    if (size != 2) {
+    if (options.modulus != 0 && !Modulus::valid(options.modulus)) {
         if (rank == 0) {
-            std::cerr << "This application is meant to be run with 2 MPI processes. Non esageriamo con le risorse. State molto calmi!" << std::endl;
+            std::cerr << "Invalid modulus: " << options.modulus << " (need 2 <= p < 2^31)" << std::endl;
         }
         MPI_Finalize();
-        return -1;
+        return 2;
+    }
+    if (options.powerMode && options.power < 0) {
+        if (rank == 0) {
+            std::cerr << "Invalid power: " << options.power << std::endl;
+        }
+        MPI_Finalize();
+        return 2;
+    }
+    SemiringKind semiring;
+    if (!parseSemiringKind(options.semiring.c_str(), semiring) ||
+        (options.modulus != 0 && semiring != SemiringKind::PlusTimes)) {
+        if (rank == 0) {
+            std::cerr << "Invalid semiring: " << options.semiring
+                      << " (plus-times, min-plus, max-plus or max-min; only plus-times with --modulus)" << std::endl;
+        }
+        MPI_Finalize();
+        return 2;
     }
 
-    int rowsA, colsA, rowsB, colsB;
-    std::vector<std::vector<int>> A, B;
-
-    if (rank == 0) {
-        readMatrixFromFile("matrixA.txt", A, rowsA, colsA);
-        readMatrixFromFile("matrixB.txt", B, rowsB, colsB);
+    // pin before allocating anything, so that first touch happens on the final cpus
+    const Placement placement = pinRankAndThreads(MPI_COMM_WORLD, options.pin);
+    if (options.placement) {
+        reportPlacement(std::cerr, rank, placement);
     }
 
-    
-    MPI_Bcast(&rowsA, 1, MPI_INT, 0, MPI_COMM_WORLD);
-    MPI_Bcast(&colsA, 1, MPI_INT, 0, MPI_COMM_WORLD);
-    MPI_Bcast(&rowsB, 1, MPI_INT, 0, MPI_COMM_WORLD);
-    MPI_Bcast(&colsB, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    // storage holds A, B and C, workspace the packed panels of the kernel
+    Arena storage(Arena::kDefaultChunkBytes, options.hugePages);
+    Arena workspace(Arena::kDefaultChunkBytes, options.hugePages);
 
-    
-    if (rank != 0) {
-        A.resize(rowsA, std::vector<int>(colsA));
+    KernelReport kernelReport;
+    PhaseTimes phases;
+    ScheduleReport schedule;
+    DistributedOptions distributed;
+    distributed.interleaveB = placement.numaPolicies;
+    distributed.sharedB = options.sharedB;
+    distributed.oneSided = options.oneSided;
+    distributed.dynamic = options.dynamic;
+    distributed.report = options.kernelReport ? &kernelReport : nullptr;
+    distributed.timings = &phases;
+    distributed.schedule = options.dynamic ? &schedule : nullptr;
+    distributed.modulus = static_cast<std::uint32_t>(options.modulus);
+    distributed.semiring = semiring;
+    // opened after pinning: one set of counters per OpenMP thread
+    std::unique_ptr<PerfCounters> counters;
+    if (options.perfCounters) {
+        counters.reset(new PerfCounters());
+        distributed.counters = counters.get();
     }
-    for (int i = 0; i < rowsA; ++i) {
-        MPI_Bcast(A[i].data(), colsA, MPI_INT, 0, MPI_COMM_WORLD);
+
+    // variants are only tuned at startup (see tuneAtStartup), never in the middle of a product
+    std::unique_ptr<KernelRegistry> registry;
+    if (!options.tuningFile.empty()) {
+        registry.reset(new KernelRegistry());
+        registry->load(options.tuningFile);
+        registry->setTuneOnMiss(false);
+        distributed.registry = registry.get();
     }
 
-    
-    if (rank != 0) {
-        B.resize(rowsB, std::vector<int>(colsB));
+    // without MPI_THREAD_MULTIPLE the run goes on with the collectives of the calling thread
+    std::unique_ptr<ProgressThread> progress;
+    if (options.progressThread && ProgressThread::supported()) {
+        progress.reset(new ProgressThread(placement.cpus));
+        distributed.progress = progress.get();
+        if (options.placement) {
+            reportProgressThread(std::cerr, rank, placement, progress->cpus());
+        }
+    } else if (options.progressThread && rank == 0) {
+        std::cerr << "[rank 0] progress thread: disabled, MPI does not provide MPI_THREAD_MULTIPLE" << std::endl;
     }
-    for (int i = 0; i < rowsB; ++i) {
-        MPI_Bcast(B[i].data(), colsB, MPI_INT, 0, MPI_COMM_WORLD);
+
+    if (!options.serveSocket.empty()) {
+        const int status = runService(options.serveSocket, MPI_COMM_WORLD, storage, workspace, distributed);
+        progress.reset();
+        MPI_Finalize();
+        return status;
+    }
+
+    if (!options.manifest.empty()) {
+        const int status = runManifest(options.manifest, MPI_COMM_WORLD, workspace,
+                                       distributed, options.pipelineDepth, placement.cpus);
+        progress.reset();
+        MPI_Finalize();
+        return status;
     }
 
-    std::vector<std::vector<int>> C(rowsA, std::vector<int>(colsB, 0));
-    multiplyMatrices(A, B, C, rowsA, colsA, colsB);
+    if (options.boolean) {
+        const int status = runBoolean(options, static_cast<int>(placement.threadCpus.size()), storage);
+        progress.reset();
+        MPI_Finalize();
+        return status;
+    }
 
+    const double start = MPI_Wtime();
+    Matrix A, B;
     if (rank == 0) {
-        std::cout << "Congratulations, bro. Here is your resultant matrix C:" << std::endl;
-        for (const auto& row : C) {
-            for (const auto& elem : row) {
-                std::cout << elem << " ";
+        loadMatrix("matrixA.txt", storage, A);
+        if (!options.powerMode) {
+            loadMatrix("matrixB.txt", storage, B);
+            checkProductShape(A.rows, A.cols, B.rows, B.cols);
+        } else if (A.rows != A.cols) {
+            std::cerr << "A^k needs a square matrix, matrixA.txt is " << A.rows << "x" << A.cols << std::endl;
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+    }
+    const double read = MPI_Wtime() - start;
+    double write = 0;
+    int status = 0;
+
+    // rank 0 looks the operands up in the result cache, on a hit nobody multiplies
+    // (powers are not cached: the key only covers products)
+    const bool cacheable = !options.cacheDirectory.empty() && !options.powerMode;
+    CacheKey key;
+    CachedResult cached;
+    int hit = 0;
+    if (rank == 0 && cacheable) {
+        ResultCache cache(options.cacheDirectory, options.cacheMaxBytes);
+        key = operandKey(A, B, distributed.modulus, distributed.semiring);
+        hit = cache.open(key, cached) ? 1 : 0;
+        std::cerr << "[rank 0] cache " << (hit ? "hit" : "miss") << ": " << key.hex() << std::endl;
+    }
+    MPI_Bcast(&hit, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+    if (hit) {
+        if (rank == 0) {
+            std::cout << "Congratulations, bro. Here is your resultant matrix C:" << std::endl;
+            if (!cached.stream(std::cout)) {
+                std::cerr << "Truncated cache entry: " << key.hex() << std::endl;
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+        }
+    } else {
+        // the modular and semiring kernels have no variants to tune, Freivalds only checks products
+        const bool ordinary = options.modulus == 0 && semiring == SemiringKind::PlusTimes && !options.powerMode;
+        if (registry && ordinary) {
+            tuneAtStartup(*registry, options, A, B, workspace);
+        }
+        std::unique_ptr<Checkpointer> checkpointer;
+        if (!options.checkpointDirectory.empty() && !options.powerMode) {
+            checkpointer.reset(new Checkpointer(options.checkpointDirectory, options.checkpointInterval, options.resume,
+                                              placement.cpus));
+            distributed.checkpointer = checkpointer.get();
+        }
+        Matrix C = options.powerMode
+                       ? distributedPower(A, options.power, MPI_COMM_WORLD, storage, workspace, distributed)
+                       : distributedMultiply(A, B, MPI_COMM_WORLD, storage, workspace, distributed);
+        if (checkpointer) {
+            checkpointer->report(std::cerr, rank);
+        }
+        if (registry && ordinary) {
+            const KernelRegistry::Lookups& lookups = registry->lookups();
+            std::cerr << "[rank " << rank << "] tuned kernels: exact=" << lookups.exact << " nearest="
+                      << lookups.nearest << " misses=" << lookups.misses << std::endl;
+        }
+        if (options.kernelReport) {
+            std::cerr << "[rank " << rank << "] kernel=" << kernelReport.kernel
+                      << " A=" << kernelReport.structureA << " B=" << kernelReport.structureB
+                      << " detect=" << kernelReport.detectSeconds << " s" << std::endl;
+        }
+        if (options.dynamic) {
+            std::cerr << "[rank " << rank << "] schedule: tiles=" << schedule.tiles
+                      << " rows=" << schedule.rows << " compute=" << phases.compute << " s" << std::endl;
+        }
+        if (options.verify && !ordinary) {
+            if (rank == 0) {
+                std::cerr << "[rank 0] verify: skipped (not an ordinary product)" << std::endl;
+            }
+        } else if (options.verify) {
+            const double t = MPI_Wtime();
+            const bool verified = distributedFreivalds(A, B, C, MPI_COMM_WORLD, storage, workspace,
+                                                       options.verifyRounds);
+            if (rank == 0) {
+                std::cerr << "[rank 0] verify: " << (verified ? "passed" : "FAILED")
+                          << " rounds=" << options.verifyRounds << " seconds=" << MPI_Wtime() - t << std::endl;
             }
-            std::cout << std::endl;
+            status = verified ? 0 : 1;
         }
+
+        if (rank == 0) {
+            const double t = MPI_Wtime();
+            std::cout << "Congratulations, bro. Here is your resultant matrix C:" << std::endl;
+            writeMatrix(std::cout, C);
+            write = MPI_Wtime() - t;
+            if (cacheable && status == 0) {
+                ResultCache cache(options.cacheDirectory, options.cacheMaxBytes);
+                cache.store(key, C);
+                cache.evict();
+            }
+        }
+    }
+
+    if (options.timings) {
+        printTimings(MPI_COMM_WORLD, static_cast<int>(placement.threadCpus.size()), read, phases, write,
+                     MPI_Wtime() - start);
     }
 
+    if (counters) {
+        counters->report(std::cerr, rank);
+    }
+
+    if (options.arenaStats) {
+        printArenaStats(rank, "storage", storage);
+        printArenaStats(rank, "workspace", workspace);
+    }
+
+    progress.reset();
     MPI_Finalize();
-    return 0;
+    return status;
 }
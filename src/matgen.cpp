@@ -0,0 +1,147 @@
+#include "arena.h"
+#include "generator.h"
+#include "matrix.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/**
+ * Synthetic input generator.
+ *
+ *   matgen ROWS COLS [--kind random|sparse|banded|identity|diagonal|symmetric|lower|upper]
+ *          [--seed S] [--min V] [--max V] [--density D] [--lower L] [--upper U]
+ *          [--binary] [--output FILE]
+ *
+ * The matrix is written in the text format read by main (or in the binary layout of matrix.h
+ * with --binary) to FILE, stdout by default. Rows are generated and formatted by the OpenMP
+ * threads in batches, and the same seed always gives the same file whatever the thread count.
+ */
+int usage() {
+    std::cerr << "usage: matgen ROWS COLS [--kind random|sparse|banded|identity|diagonal|symmetric|lower|upper]"
+                 " [--seed S] [--min V] [--max V] [--density D] [--lower L] [--upper U] [--binary] [--output FILE]"
+              << std::endl;
+    return 2;
+}
+
+/**
+ * Rows of `block` in the text layout ("v v v\n"), threads formatting consecutive ranges into
+ * their own buffer; the buffers are returned in row order.
+ */
+void formatRows(const Matrix& block, std::vector<std::string>& buffers) {
+#pragma omp parallel num_threads(static_cast<int>(buffers.size()))
+    {
+        int threads = 1, tid = 0;
+#ifdef _OPENMP
+        threads = omp_get_num_threads();
+        tid = omp_get_thread_num();
+#endif
+        int begin, end;
+        blockRange(block.rows, threads, tid, begin, end);
+        std::string& text = buffers[tid];
+        text.resize(static_cast<std::size_t>(end - begin) * (static_cast<std::size_t>(block.cols) * 12 + 1));
+        char* out = &text[0];
+        for (int i = begin; i < end; ++i) {
+            const int* r = block.row(i);
+            for (int j = 0; j < block.cols; ++j) {
+                if (j > 0) {
+                    *out++ = ' ';
+                }
+                out = std::to_chars(out, out + 11, r[j]).ptr;
+            }
+            *out++ = '\n';
+        }
+        text.resize(static_cast<std::size_t>(out - text.data()));
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        return usage();
+    }
+    GeneratorSpec spec;
+    spec.rows = std::atoi(argv[1]);
+    spec.cols = std::atoi(argv[2]);
+    bool binary = false;
+    std::string output;
+    for (int i = 3; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--kind") == 0 && i + 1 < argc) {
+            if (!parseMatrixKind(argv[++i], spec.kind)) {
+                return usage();
+            }
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            spec.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--min") == 0 && i + 1 < argc) {
+            spec.minValue = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--max") == 0 && i + 1 < argc) {
+            spec.maxValue = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--density") == 0 && i + 1 < argc) {
+            spec.density = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--lower") == 0 && i + 1 < argc) {
+            spec.lowerBandwidth = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--upper") == 0 && i + 1 < argc) {
+            spec.upperBandwidth = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--binary") == 0) {
+            binary = true;
+        } else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else {
+            return usage();
+        }
+    }
+    if (spec.rows < 0 || spec.cols < 0 || spec.minValue > spec.maxValue) {
+        return usage();
+    }
+
+    std::FILE* out = output.empty() ? stdout : std::fopen(output.c_str(), "wb");
+    if (out == nullptr) {
+        std::cerr << "Error opening file: " << output << std::endl;
+        return 1;
+    }
+    if (binary) {
+        const std::int32_t dims[2] = {spec.rows, spec.cols};
+        std::fwrite(kBinaryMatrixMagic, 1, sizeof(kBinaryMatrixMagic) - 1, out);
+        std::fwrite(dims, sizeof(dims), 1, out);
+    } else {
+        std::fprintf(out, "%d %d\n", spec.rows, spec.cols);
+    }
+
+    // batches of about 4 MiB of elements, generated in parallel then written in order
+    Arena arena;
+    const int batchRows = std::max(1, std::min(spec.rows, (1 << 20) / std::max(spec.cols, 1)));
+    Matrix batch = allocateMatrix(arena, batchRows, spec.cols);
+    int threads = 1;
+#ifdef _OPENMP
+    threads = omp_get_max_threads();
+#endif
+    std::vector<std::string> buffers(threads);
+    for (int first = 0; first < spec.rows; first += batchRows) {
+        Matrix block = rowBlock(batch, 0, std::min(batchRows, spec.rows - first));
+        generateRows(spec, first, block);
+        if (binary) {
+            for (int i = 0; i < block.rows; ++i) {
+                std::fwrite(block.row(i), sizeof(int), block.cols, out);
+            }
+        } else {
+            formatRows(block, buffers);
+            for (const std::string& text : buffers) {
+                std::fwrite(text.data(), 1, text.size(), out);
+            }
+        }
+    }
+
+    const bool failed = std::ferror(out) != 0;
+    if ((out != stdout ? std::fclose(out) : std::fflush(out)) != 0 || failed) {
+        std::cerr << "Error writing file: " << (output.empty() ? "stdout" : output) << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include "matrix.h"
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <ostream>
+
+int paddedStride(int cols) {
+    constexpr int kIntsPerLine = static_cast<int>(Arena::kAlignment / sizeof(int));
+    return (cols + kIntsPerLine - 1) / kIntsPerLine * kIntsPerLine;
+}
+
+Matrix allocateMatrix(Arena& arena, int rows, int cols) {
+    Matrix M;
+    M.rows = rows;
+    M.cols = cols;
+    M.stride = paddedStride(cols);
+    M.data = arena.allocateArray<int>(M.storageSize());
+    return M;
+}
+
+void fillMatrix(Matrix& M, int value) {
+    if (M.padded) {
+        std::fill(M.data, M.data + M.storageSize(), value);
+        return;
+    }
+    for (int i = 0; i < M.rows; ++i) {
+        std::fill(M.row(i), M.row(i) + M.cols, value);
+    }
+}
+
+Matrix rowBlock(const Matrix& M, int begin, int count) {
+    Matrix block = M;
+    block.rows = count;
+    block.data = M.data + static_cast<std::size_t>(begin) * M.stride;
+    return block;
+}
+
+Matrix subMatrix(const Matrix& M, int row, int col, int rows, int cols) {
+    Matrix view = rowBlock(M, row, rows);
+    view.data += col;
+    view.cols = cols;
+    view.padded = M.padded && col == 0 && cols == M.cols;
+    return view;
+}
+
+void blockRange(int count, int parts, int part, int& begin, int& end) {
+    const int base = count / parts;
+    const int extra = count % parts;
+    begin = part * base + (part < extra ? part : extra);
+    end = begin + base + (part < extra ? 1 : 0);
+}
+
+std::vector<int> guidedRanges(int count, int parts, int minSize) {
+    std::vector<int> bounds = {0};
+    int begin = 0;
+    while (begin < count) {
+        const int left = count - begin;
+        const int size = std::max((left + 2 * parts - 1) / (2 * parts), minSize);
+        begin += std::min(size, left);
+        bounds.push_back(begin);
+    }
+    return bounds;
+}
+
+namespace {
+
+bool readBinaryMatrix(std::istream& in, Arena& arena, Matrix& matrix) {
+    std::int32_t dims[2];
+    if (!in.read(reinterpret_cast<char*>(dims), sizeof(dims)) || dims[0] < 0 || dims[1] < 0) {
+        return false;
+    }
+    matrix = allocateMatrix(arena, dims[0], dims[1]);
+    for (int i = 0; i < matrix.rows; ++i) {
+        int* r = matrix.row(i);
+        if (!in.read(reinterpret_cast<char*>(r), static_cast<std::streamsize>(matrix.cols) * sizeof(int))) {
+            return false;
+        }
+        std::fill(r + matrix.cols, r + matrix.stride, 0);
+    }
+    return true;
+}
+
+}
+
+bool readMatrixFromFile(const std::string& filename, Arena& arena, Matrix& matrix) {
+    std::ifstream infile(filename, std::ios::binary);
+    if (!infile) {
+        return false;
+    }
+
+    char magic[sizeof(kBinaryMatrixMagic) - 1];
+    if (infile.read(magic, sizeof(magic)) && std::equal(magic, magic + sizeof(magic), kBinaryMatrixMagic)) {
+        return readBinaryMatrix(infile, arena, matrix);
+    }
+    infile.clear();
+    infile.seekg(0);
+
+    int rows, cols;
+    if (!(infile >> rows >> cols) || rows < 0 || cols < 0) {
+        return false;
+    }
+    matrix = allocateMatrix(arena, rows, cols);
+
+    for (int i = 0; i < rows; ++i) {
+        int* r = matrix.row(i);
+        for (int j = 0; j < cols; ++j) {
+            infile >> r[j];
+        }
+        std::fill(r + cols, r + matrix.stride, 0);
+    }
+    return static_cast<bool>(infile);
+}
+
+void writeMatrix(std::ostream& out, const Matrix& M) {
+    for (int i = 0; i < M.rows; ++i) {
+        const int* r = M.row(i);
+        for (int j = 0; j < M.cols; ++j) {
+            out << r[j] << " ";
+        }
+        out << '\n';
+    }
+    out.flush();
+}
+
+void writeMatrixBinary(std::ostream& out, const Matrix& M) {
+    const std::int32_t dims[2] = {M.rows, M.cols};
+    out.write(kBinaryMatrixMagic, sizeof(kBinaryMatrixMagic) - 1);
+    out.write(reinterpret_cast<const char*>(dims), sizeof(dims));
+    for (int i = 0; i < M.rows; ++i) {
+        out.write(reinterpret_cast<const char*>(M.row(i)), static_cast<std::streamsize>(M.cols) * sizeof(int));
+    }
+    out.flush();
+}
+
+Matrix fromNested(Arena& arena, const std::vector<std::vector<int>>& nested) {
+    int rows = static_cast<int>(nested.size());
+    int cols = rows == 0 ? 0 : static_cast<int>(nested[0].size());
+    Matrix M = allocateMatrix(arena, rows, cols);
+    fillMatrix(M, 0);
+    for (int i = 0; i < rows; ++i) {
+        std::copy(nested[i].begin(), nested[i].begin() + cols, M.row(i));
+    }
+    return M;
+}
+
+std::vector<std::vector<int>> toNested(const Matrix& M) {
+    std::vector<std::vector<int>> nested(M.rows);
+    for (int i = 0; i < M.rows; ++i) {
+        nested[i].assign(M.row(i), M.row(i) + M.cols);
+    }
+    return nested;
+}
@@ -0,0 +1,118 @@
+#include "modular.h"
+#include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+
+/**
+ * acc[j] = acc[j] mod p for 64-bit accumulators, vectorisable: the Barrett quotient is
+ * estimated from three 32 x 32 -> 64 partial products (the low x low one and the carries
+ * are dropped), which undershoots floor(x / p) by at most 5, fixed by conditional subtractions.
+ */
+void reduceAccumulators(std::uint64_t* acc, int n, std::uint64_t p, std::uint64_t barrett) {
+    const std::uint64_t mh = barrett >> 32, ml = barrett & 0xffffffffULL;
+#pragma omp simd
+    for (int j = 0; j < n; ++j) {
+        const std::uint64_t x = acc[j];
+        const std::uint64_t xh = x >> 32, xl = x & 0xffffffffULL;
+        const std::uint64_t q = xh * mh + ((xh * ml) >> 32) + ((xl * mh) >> 32);
+        std::uint64_t r = x - q * p;
+        for (int fix = 0; fix < 5; ++fix) {
+            r = r >= p ? r - p : r;
+        }
+        acc[j] = r;
+    }
+}
+
+}
+
+Modulus::Modulus(std::uint32_t p) : p(p), barrett(~std::uint64_t(0) / p) {
+    const std::uint64_t largest = static_cast<std::uint64_t>(p - 1) * (p - 1);
+    const std::uint64_t room = ~std::uint64_t(0) - (p - 1);
+    delay = static_cast<int>(std::min<std::uint64_t>(largest == 0 ? 1 << 30 : room / largest, 1 << 30));
+}
+
+std::uint32_t Modulus::reduce(std::uint64_t x) const {
+    return static_cast<std::uint32_t>(x % p);
+}
+
+std::uint32_t Modulus::reduce(int x) const {
+    const std::int64_t r = static_cast<std::int64_t>(x) % static_cast<std::int64_t>(p);
+    return static_cast<std::uint32_t>(r < 0 ? r + p : r);
+}
+
+void multiplyModular(const Matrix& A, const Matrix& B, Matrix& C, const Modulus& modulus,
+                     Arena& workspace, const BlockSizes& blocks) {
+    int maxThreads = 1;
+#ifdef _OPENMP
+    maxThreads = omp_get_max_threads();
+#endif
+    Arena::Scope scratch(workspace);
+    const int kc = std::max(std::min(blocks.kc, A.cols), 1);
+    const int nc = std::max(std::min(blocks.nc, B.cols), 1);
+    const std::size_t panelSize = static_cast<std::size_t>(kc) * nc;
+    std::uint32_t* panels = workspace.allocateArray<std::uint32_t>(panelSize * maxThreads);
+    std::uint64_t* accumulators = workspace.allocateArray<std::uint64_t>(static_cast<std::size_t>(nc) * maxThreads);
+    std::uint32_t* residues = workspace.allocateArray<std::uint32_t>(static_cast<std::size_t>(kc) * maxThreads);
+    const std::uint64_t p = modulus.p;
+
+#pragma omp parallel num_threads(maxThreads)
+    {
+        int threads = 1, tid = 0;
+#ifdef _OPENMP
+        threads = omp_get_num_threads();
+        tid = omp_get_thread_num();
+#endif
+        int begin, end;
+        blockRange(A.rows, threads, tid, begin, end);
+        Matrix myC = rowBlock(C, begin, end - begin);
+        fillMatrix(myC, 0);
+        std::uint32_t* panel = panels + panelSize * tid;
+        std::uint64_t* acc = accumulators + static_cast<std::size_t>(nc) * tid;
+        std::uint32_t* a = residues + static_cast<std::size_t>(kc) * tid;
+
+        for (int j0 = 0; begin < end && j0 < B.cols; j0 += blocks.nc) {
+            const int n = std::min(blocks.nc, B.cols - j0);
+            for (int k0 = 0; k0 < A.cols; k0 += blocks.kc) {
+                const int k = std::min(blocks.kc, A.cols - k0);
+                for (int kk = 0; kk < k; ++kk) {
+                    const int* src = B.row(k0 + kk) + j0;
+                    std::uint32_t* dst = panel + static_cast<std::size_t>(kk) * n;
+                    for (int j = 0; j < n; ++j) {
+                        dst[j] = modulus.reduce(src[j]);
+                    }
+                }
+                for (int i = begin; i < end; ++i) {
+                    const int* row = A.row(i) + k0;
+                    for (int kk = 0; kk < k; ++kk) {
+                        a[kk] = modulus.reduce(row[kk]);
+                    }
+                    // C holds the reduced partial sum of the previous panels
+                    int* c = C.row(i) + j0;
+                    for (int j = 0; j < n; ++j) {
+                        acc[j] = static_cast<std::uint32_t>(c[j]);
+                    }
+                    int pending = 0;
+                    for (int kk = 0; kk < k; ++kk) {
+                        const std::uint64_t aik = a[kk];
+                        const std::uint32_t* b = panel + static_cast<std::size_t>(kk) * n;
+#pragma omp simd
+                        for (int j = 0; j < n; ++j) {
+                            acc[j] += aik * b[j];
+                        }
+                        if (++pending == modulus.delay) {
+                            reduceAccumulators(acc, n, p, modulus.barrett);
+                            pending = 0;
+                        }
+                    }
+                    reduceAccumulators(acc, n, p, modulus.barrett);
+                    for (int j = 0; j < n; ++j) {
+                        c[j] = static_cast<int>(acc[j]);
+                    }
+                }
+            }
+        }
+    }
+}
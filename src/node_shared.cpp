@@ -0,0 +1,58 @@
+#include "node_shared.h"
+#include "placement.h"
+#include <algorithm>
+
+NodeSharedMatrix::NodeSharedMatrix(MPI_Comm comm, int rows, int cols) {
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+    // key = rank keeps rank 0 first on its node and first among the leaders
+    MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_);
+    MPI_Comm_rank(node_, &nodeRank_);
+    MPI_Comm_size(node_, &nodeSize_);
+    MPI_Comm_split(comm, nodeRank_ == 0 ? 0 : MPI_UNDEFINED, rank, &leaders_);
+
+    matrix_.rows = rows;
+    matrix_.cols = cols;
+    matrix_.stride = paddedStride(cols);
+    const MPI_Aint bytes = nodeRank_ == 0 ? static_cast<MPI_Aint>(matrix_.storageSize() * sizeof(int)) : 0;
+    void* base = nullptr;
+    MPI_Win_allocate_shared(bytes, sizeof(int), MPI_INFO_NULL, node_, &base, &window_);
+    MPI_Aint size;
+    int unit;
+    MPI_Win_shared_query(window_, 0, &size, &unit, &base);
+    matrix_.data = static_cast<int*>(base);
+
+    // passive target epoch for the whole lifetime: the ranks only synchronise with MPI_Win_sync
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, window_);
+}
+
+NodeSharedMatrix::~NodeSharedMatrix() {
+    MPI_Win_unlock_all(window_);
+    MPI_Win_free(&window_);
+    if (leaders_ != MPI_COMM_NULL) {
+        MPI_Comm_free(&leaders_);
+    }
+    MPI_Comm_free(&node_);
+}
+
+void NodeSharedMatrix::broadcast(const Matrix& source, bool interleave) {
+    if (leader()) {
+        if (interleave) {
+            interleaveMemory(matrix_.data, matrix_.storageSize() * sizeof(int));
+        }
+        int leaderRank;
+        MPI_Comm_rank(leaders_, &leaderRank);
+        if (leaderRank == 0) {
+            std::copy(source.data, source.data + source.storageSize(), matrix_.data);
+        }
+        MPI_Datatype row;
+        MPI_Type_contiguous(matrix_.stride, MPI_INT, &row);
+        MPI_Type_commit(&row);
+        MPI_Bcast(matrix_.data, matrix_.rows, row, 0, leaders_);
+        MPI_Type_free(&row);
+    }
+    // make the leader's stores visible before anybody on the node reads them
+    MPI_Win_sync(window_);
+    MPI_Barrier(node_);
+    MPI_Win_sync(window_);
+}
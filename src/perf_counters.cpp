@@ -0,0 +1,169 @@
+#include "perf_counters.h"
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <ostream>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+
+const char* const kEventNames[kPerfEventCount] = {
+    "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses",
+};
+
+void describeEvent(int event, perf_event_attr& attr) {
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    switch (event) {
+    case kCycles:
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+    case kInstructions:
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+    case kL1dMisses:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        break;
+    case kLlcMisses:
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        break;
+    default:
+        attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+        break;
+    }
+}
+
+/**
+ * Counter of `event` for the calling thread, -1 (and errno set) if refused.
+ */
+int openEvent(int event) {
+    perf_event_attr attr;
+    describeEvent(event, attr);
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+}
+
+CounterValues CounterValues::operator-(const CounterValues& earlier) const {
+    CounterValues delta;
+    for (int e = 0; e < kPerfEventCount; ++e) {
+        delta.valid[e] = valid[e] && earlier.valid[e];
+        delta.count[e] = delta.valid[e] ? count[e] - earlier.count[e] : 0;
+    }
+    return delta;
+}
+
+PerfCounters::PerfCounters() {
+    int threads = 1;
+#ifdef _OPENMP
+    threads = omp_get_max_threads();
+#endif
+    fds_.assign(static_cast<std::size_t>(threads) * kPerfEventCount, -1);
+    int firstError = 0;
+#pragma omp parallel num_threads(threads)
+    {
+        int tid = 0;
+#ifdef _OPENMP
+        tid = omp_get_thread_num();
+#endif
+        for (int e = 0; e < kPerfEventCount; ++e) {
+            const int fd = openEvent(e);
+            fds_[static_cast<std::size_t>(tid) * kPerfEventCount + e] = fd;
+            if (fd < 0) {
+#pragma omp critical(perf_counters_error)
+                if (firstError == 0) {
+                    firstError = errno;
+                }
+            }
+        }
+    }
+    for (int fd : fds_) {
+        available_ = available_ || fd >= 0;
+    }
+    if (!available_) {
+        error_ = std::string("perf_event_open: ") + std::strerror(firstError);
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    for (int fd : fds_) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+CounterValues PerfCounters::read() const {
+    CounterValues values;
+    if (!available_) {
+        return values;
+    }
+    for (int e = 0; e < kPerfEventCount; ++e) {
+        values.valid[e] = true;
+    }
+    for (std::size_t i = 0; i < fds_.size(); ++i) {
+        const int e = static_cast<int>(i % kPerfEventCount);
+        std::uint64_t data[3];  // value, time enabled, time running
+        if (fds_[i] < 0 || ::read(fds_[i], data, sizeof(data)) != static_cast<ssize_t>(sizeof(data))) {
+            values.valid[e] = false;
+            continue;
+        }
+        // multiplexed counters only ran for part of the time: extrapolate
+        const double scale = data[2] > 0 ? static_cast<double>(data[1]) / static_cast<double>(data[2]) : 0;
+        values.count[e] += static_cast<std::uint64_t>(static_cast<double>(data[0]) * scale);
+    }
+    return values;
+}
+
+void PerfCounters::add(const std::string& region, const CounterValues& delta, double flops, double seconds) {
+    Region& r = regions_[region];
+    for (int e = 0; e < kPerfEventCount; ++e) {
+        r.values.valid[e] = (r.calls == 0 || r.values.valid[e]) && delta.valid[e];
+        r.values.count[e] += delta.count[e];
+    }
+    r.flops += flops;
+    r.seconds += seconds;
+    ++r.calls;
+}
+
+void PerfCounters::report(std::ostream& out, int rank) const {
+    if (!available_) {
+        out << "[rank " << rank << "] counters unavailable: " << error_ << std::endl;
+        return;
+    }
+    for (const auto& entry : regions_) {
+        const Region& r = entry.second;
+        out << "[rank " << rank << "] counters " << entry.first << ": calls=" << r.calls << " seconds=" << r.seconds;
+        for (int e = 0; e < kPerfEventCount; ++e) {
+            out << " " << kEventNames[e] << "=";
+            if (r.values.valid[e]) {
+                out << r.values.count[e];
+            } else {
+                out << "n/a";
+            }
+        }
+        if (r.values.valid[kCycles] && r.values.valid[kInstructions] && r.values.count[kCycles] > 0) {
+            out << " ipc=" << static_cast<double>(r.values.count[kInstructions]) / r.values.count[kCycles];
+        }
+        if (r.flops > 0) {
+            out << " flops=" << r.flops;
+            if (r.values.valid[kL1dMisses]) {
+                out << " l1d_misses_per_flop=" << r.values.count[kL1dMisses] / r.flops;
+            }
+            if (r.values.valid[kLlcMisses]) {
+                out << " llc_misses_per_flop=" << r.values.count[kLlcMisses] / r.flops;
+            }
+        }
+        out << std::endl;
+    }
+}
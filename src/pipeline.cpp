@@ -0,0 +1,184 @@
+#include "pipeline.h"
+#include "bounded_queue.h"
+#include "distributed.h"
+#include "matrix.h"
+#include "placement.h"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+enum Command : int {
+    kStop = 0,
+    kMultiply = 1,
+};
+
+struct Job {
+    int index = 0;
+    std::string pathA, pathB, pathC;
+    Arena* arena = nullptr;
+    Matrix A, B, C;
+    std::string error;
+};
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool readManifest(const std::string& manifest, std::vector<Job>& jobs) {
+    std::ifstream in(manifest);
+    if (!in) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        Job job;
+        if (!(fields >> job.pathA) || job.pathA[0] == '#') {
+            continue;
+        }
+        fields >> job.pathB >> job.pathC;
+        job.index = static_cast<int>(jobs.size()) + 1;
+        jobs.push_back(job);
+    }
+    return true;
+}
+
+void parseJob(Job& job) {
+    if (job.pathB.empty()) {
+        job.error = "missing operand B";
+    } else if (!readMatrixFromFile(job.pathA, *job.arena, job.A)) {
+        job.error = "Error opening file: " + job.pathA;
+    } else if (!readMatrixFromFile(job.pathB, *job.arena, job.B)) {
+        job.error = "Error opening file: " + job.pathB;
+    } else if (job.A.cols != job.B.rows) {
+        job.error = "the number of columns of A differs from the number of rows of B";
+    }
+}
+
+bool writeJob(const Job& job) {
+    if (!job.error.empty()) {
+        std::cerr << "[pipeline] job " << job.index << " (" << job.pathA << " * " << job.pathB << "): "
+                  << job.error << std::endl;
+        return false;
+    }
+    if (job.pathC.empty()) {
+        std::cout << "Congratulations, bro. Here is your resultant matrix C for "
+                  << job.pathA << " * " << job.pathB << ":" << std::endl;
+        writeMatrix(std::cout, job.C);
+        return true;
+    }
+    std::ofstream out(job.pathC);
+    out << job.C.rows << " " << job.C.cols << "\n";
+    writeMatrix(out, job.C);
+    if (!out) {
+        std::cerr << "[pipeline] job " << job.index << ": cannot write " << job.pathC << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int runWorker(MPI_Comm comm, Arena& workspace, const DistributedOptions& options) {
+    Arena storage;
+    for (;;) {
+        int command;
+        MPI_Bcast(&command, 1, MPI_INT, 0, comm);
+        if (command == kStop) {
+            break;
+        }
+        distributedMultiply(Matrix(), Matrix(), comm, storage, workspace, options);
+        storage.reset();
+    }
+    int failed = 0;
+    MPI_Bcast(&failed, 1, MPI_INT, 0, comm);
+    return failed ? 1 : 0;
+}
+
+}
+
+int runManifest(const std::string& manifest, MPI_Comm comm, Arena& workspace,
+                const DistributedOptions& options, int depth, const std::vector<int>& helperCpus) {
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+    if (rank != 0) {
+        return runWorker(comm, workspace, options);
+    }
+
+    std::vector<Job> jobs;
+    if (!readManifest(manifest, jobs)) {
+        std::cerr << "Error opening file: " << manifest << std::endl;
+        MPI_Abort(comm, 1);
+    }
+
+    depth = depth < 1 ? 1 : depth;
+    std::vector<std::unique_ptr<Arena>> arenas;
+    BoundedQueue<Arena*> freeArenas(depth);
+    for (int i = 0; i < depth; ++i) {
+        arenas.emplace_back(new Arena());
+        freeArenas.push(arenas.back().get());
+    }
+    BoundedQueue<Job> parsed(depth);
+    BoundedQueue<Job> computed(depth);
+
+    const auto start = std::chrono::steady_clock::now();
+    double readSeconds = 0, computeSeconds = 0, writeSeconds = 0;
+    int failed = 0;
+
+    std::thread reader([&] {
+        for (Job& job : jobs) {
+            if (!freeArenas.pop(job.arena)) {
+                break;
+            }
+            const auto t = std::chrono::steady_clock::now();
+            parseJob(job);
+            readSeconds += secondsSince(t);
+            parsed.push(job);
+        }
+        parsed.close();
+    });
+    pinHelperThread(reader, helperCpus);
+
+    std::thread writer([&] {
+        Job job;
+        while (computed.pop(job)) {
+            const auto t = std::chrono::steady_clock::now();
+            if (!writeJob(job)) {
+                ++failed;
+            }
+            writeSeconds += secondsSince(t);
+            job.arena->reset();
+            freeArenas.push(job.arena);
+        }
+    });
+    pinHelperThread(writer, helperCpus);
+
+    // compute stage: the reader and writer never call MPI, only this thread (and the progress thread)
+    Job job;
+    while (parsed.pop(job)) {
+        if (job.error.empty()) {
+            const auto t = std::chrono::steady_clock::now();
+            int command = kMultiply;
+            MPI_Bcast(&command, 1, MPI_INT, 0, comm);
+            job.C = distributedMultiply(job.A, job.B, comm, *job.arena, workspace, options);
+            computeSeconds += secondsSince(t);
+        }
+        computed.push(job);
+    }
+    computed.close();
+    writer.join();
+    reader.join();
+
+    int command = kStop;
+    MPI_Bcast(&command, 1, MPI_INT, 0, comm);
+    MPI_Bcast(&failed, 1, MPI_INT, 0, comm);
+
+    std::cerr << "[pipeline] " << jobs.size() << " jobs (" << failed << " failed) in " << secondsSince(start)
+              << " s; busy read=" << readSeconds << " s compute=" << computeSeconds
+              << " s write=" << writeSeconds << " s; depth=" << depth << std::endl;
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,225 @@
+#include "placement.h"
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <sys/syscall.h>
+#if __has_include(<numaif.h>)
+#include <numaif.h>
+#define MATRIX_HAVE_NUMAIF 1
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+
+std::vector<int> cpusOf(const cpu_set_t& set) {
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &set)) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+cpu_set_t setOf(const std::vector<int>& cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    return set;
+}
+
+std::vector<int> allowedCpus() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        return std::vector<int>();
+    }
+    return cpusOf(set);
+}
+
+bool pinTo(const std::vector<int>& cpus) {
+    const cpu_set_t set = setOf(cpus);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+int numaNodeCount() {
+    DIR* dir = opendir("/sys/devices/system/node");
+    if (dir == nullptr) {
+        return 1;
+    }
+    int count = 0;
+    while (dirent* entry = readdir(dir)) {
+        if (std::strncmp(entry->d_name, "node", 4) == 0 && entry->d_name[4] >= '0' && entry->d_name[4] <= '9') {
+            ++count;
+        }
+    }
+    closedir(dir);
+    return count > 0 ? count : 1;
+}
+
+}
+
+int numaNodeOfCpu(int cpu) {
+    const std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    DIR* dir = opendir(path.c_str());
+    if (dir == nullptr) {
+        return 0;
+    }
+    int node = 0;
+    while (dirent* entry = readdir(dir)) {
+        if (std::strncmp(entry->d_name, "node", 4) == 0 && entry->d_name[4] >= '0' && entry->d_name[4] <= '9') {
+            node = std::atoi(entry->d_name + 4);
+            break;
+        }
+    }
+    closedir(dir);
+    return node;
+}
+
+bool interleaveMemory(void* data, std::size_t bytes) {
+#if defined(MATRIX_HAVE_NUMAIF) && defined(SYS_mbind)
+    const int nodes = numaNodeCount();
+    if (nodes < 2 || bytes == 0) {
+        return false;
+    }
+    // mbind wants page aligned ranges: shrink to the pages fully inside the buffer
+    const std::uintptr_t page = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+    std::uintptr_t begin = (reinterpret_cast<std::uintptr_t>(data) + page - 1) / page * page;
+    std::uintptr_t end = (reinterpret_cast<std::uintptr_t>(data) + bytes) / page * page;
+    if (end <= begin) {
+        return false;
+    }
+    unsigned long mask[4] = {0, 0, 0, 0};
+    for (int node = 0; node < nodes && node < 256; ++node) {
+        mask[node / 64] |= 1UL << (node % 64);
+    }
+    return syscall(SYS_mbind, begin, end - begin, MPOL_INTERLEAVE, mask, 256UL, MPOL_MF_MOVE) == 0;
+#else
+    (void) data;
+    (void) bytes;
+    return false;
+#endif
+}
+
+void firstTouchRows(Matrix& M) {
+#pragma omp parallel
+    {
+        int threads = 1, tid = 0;
+#ifdef _OPENMP
+        threads = omp_get_num_threads();
+        tid = omp_get_thread_num();
+#endif
+        int begin, end;
+        blockRange(M.rows, threads, tid, begin, end);
+        Matrix mine = rowBlock(M, begin, end - begin);
+        fillMatrix(mine, 0);
+    }
+}
+
+Placement pinRankAndThreads(MPI_Comm comm, bool pin) {
+    Placement placement;
+
+    MPI_Comm node;
+    MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &node);
+    MPI_Comm_rank(node, &placement.localRank);
+    MPI_Comm_size(node, &placement.localSize);
+
+    // if the co-located ranks share the same mask (the one given by SLURM to the job) we split it,
+    // if the launcher already bound every rank to its own subset we keep that binding
+    std::vector<int> cpus = allowedCpus();
+    cpu_set_t mine, all, common;
+    CPU_ZERO(&mine);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &mine);
+    }
+    MPI_Allreduce(&mine, &all, sizeof(cpu_set_t), MPI_BYTE, MPI_BOR, node);
+    MPI_Allreduce(&mine, &common, sizeof(cpu_set_t), MPI_BYTE, MPI_BAND, node);
+    MPI_Comm_free(&node);
+    const bool sharedMask = CPU_EQUAL(&all, &common);
+
+    if (pin && !sharedMask && !cpus.empty()) {
+        placement.pinned = true;
+    } else if (pin && !cpus.empty()) {
+        if (static_cast<int>(cpus.size()) >= placement.localSize) {
+            int begin, end;
+            blockRange(static_cast<int>(cpus.size()), placement.localSize, placement.localRank, begin, end);
+            cpus = std::vector<int>(cpus.begin() + begin, cpus.begin() + end);
+        } else {
+            // more ranks than cpus: share them round robin
+            cpus = {cpus[placement.localRank % cpus.size()]};
+        }
+        placement.pinned = pinTo(cpus);
+    }
+    placement.cpus = cpus;
+    for (int cpu : cpus) {
+        placement.numaNodes.push_back(numaNodeOfCpu(cpu));
+    }
+
+#ifdef _OPENMP
+    if (pin && std::getenv("OMP_NUM_THREADS") == nullptr && !cpus.empty()) {
+        omp_set_num_threads(static_cast<int>(cpus.size()));
+    }
+    placement.threadCpus.assign(omp_get_max_threads(), -1);
+#pragma omp parallel
+    {
+        const int tid = omp_get_thread_num();
+        if (placement.pinned) {
+            const int cpu = cpus[tid % cpus.size()];
+            if (pinTo({cpu})) {
+                placement.threadCpus[tid] = cpu;
+            }
+        }
+    }
+#else
+    placement.threadCpus.assign(1, placement.pinned && cpus.size() == 1 ? cpus[0] : -1);
+#endif
+
+#if defined(MATRIX_HAVE_NUMAIF) && defined(SYS_mbind)
+    placement.numaPolicies = numaNodeCount() > 1;
+#endif
+    return placement;
+}
+
+bool pinHelperThread(std::thread& thread, const std::vector<int>& cpus) {
+    if (cpus.empty()) {
+        return false;
+    }
+    const cpu_set_t set = setOf(cpus);
+    return pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) == 0;
+}
+
+std::vector<int> threadAffinity(std::thread& thread) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (pthread_getaffinity_np(thread.native_handle(), sizeof(set), &set) != 0) {
+        return std::vector<int>();
+    }
+    return cpusOf(set);
+}
+
+void reportPlacement(std::ostream& out, int rank, const Placement& placement) {
+    out << "[rank " << rank << "] placement: local_rank=" << placement.localRank << "/" << placement.localSize
+        << " pinned=" << (placement.pinned ? "yes" : "no") << " cpus=";
+    for (std::size_t i = 0; i < placement.cpus.size(); ++i) {
+        out << (i ? "," : "") << placement.cpus[i];
+    }
+    out << " numa_nodes=";
+    for (std::size_t i = 0; i < placement.numaNodes.size(); ++i) {
+        out << (i ? "," : "") << placement.numaNodes[i];
+    }
+    out << " threads=";
+    for (std::size_t i = 0; i < placement.threadCpus.size(); ++i) {
+        out << (i ? "," : "") << placement.threadCpus[i];
+    }
+    out << " B_policy=" << (placement.numaPolicies ? "interleave" : "first-touch") << std::endl;
+}
@@ -0,0 +1,102 @@
+#include "progress.h"
+#include "placement.h"
+#include <chrono>
+#include <vector>
+
+ProgressThread::ProgressThread(const std::vector<int>& cpus, std::size_t capacity) : queue_(capacity) {
+    thread_ = std::thread([this] { run(); });
+    pinHelperThread(thread_, cpus);
+}
+
+ProgressThread::~ProgressThread() {
+    stop_.store(true, std::memory_order_release);
+    thread_.join();
+}
+
+void ProgressThread::submit(Transfer& transfer) {
+    transfer.done.store(false, std::memory_order_relaxed);
+    while (!queue_.tryPush(&transfer)) {
+        std::this_thread::yield();
+    }
+}
+
+void ProgressThread::wait(const Transfer& transfer) {
+    while (!transfer.isDone()) {
+        std::this_thread::yield();
+    }
+}
+
+void ProgressThread::waitAll(const Transfer* transfers, int count) {
+    for (int i = 0; i < count; ++i) {
+        wait(transfers[i]);
+    }
+}
+
+std::vector<int> ProgressThread::cpus() {
+    return threadAffinity(thread_);
+}
+
+bool ProgressThread::supported() {
+    int provided;
+    MPI_Query_thread(&provided);
+    return provided == MPI_THREAD_MULTIPLE;
+}
+
+void ProgressThread::run() {
+    std::vector<MPI_Request> requests;
+    std::vector<Transfer*> active;
+    std::vector<int> completed;
+    for (;;) {
+        // read before draining: whatever was submitted before the destructor is in the queue now
+        const bool stopping = stop_.load(std::memory_order_acquire);
+        bool idle = true;
+
+        Transfer* transfer;
+        while (queue_.tryPop(transfer)) {
+            MPI_Request request;
+            if (transfer->kind == Transfer::Kind::Send) {
+                MPI_Isend(transfer->buffer, transfer->count, transfer->type, transfer->peer, transfer->tag,
+                          transfer->comm, &request);
+            } else {
+                MPI_Irecv(transfer->buffer, transfer->count, transfer->type, transfer->peer, transfer->tag,
+                          transfer->comm, &request);
+            }
+            requests.push_back(request);
+            active.push_back(transfer);
+            idle = false;
+        }
+
+        if (!active.empty()) {
+            completed.resize(active.size());
+            int count = 0;
+            MPI_Testsome(static_cast<int>(requests.size()), requests.data(), &count, completed.data(),
+                         MPI_STATUSES_IGNORE);
+            if (count != MPI_UNDEFINED && count > 0) {
+                for (int i = 0; i < count; ++i) {
+                    active[completed[i]]->done.store(true, std::memory_order_release);
+                    active[completed[i]] = nullptr;
+                }
+                // compact, keeping the posting order
+                std::size_t kept = 0;
+                for (std::size_t i = 0; i < active.size(); ++i) {
+                    if (active[i] != nullptr) {
+                        active[kept] = active[i];
+                        requests[kept] = requests[i];
+                        ++kept;
+                    }
+                }
+                active.resize(kept);
+                requests.resize(kept);
+            }
+            idle = false;
+            std::this_thread::yield();
+        }
+
+        if (idle) {
+            if (stopping) {
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+}
@@ -0,0 +1,248 @@
+#include "quantized.h"
+#include <immintrin.h>
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+
+bool hasAvx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+bool hasAvx512Bw() {
+    static const bool supported = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+    return supported;
+}
+
+bool hasAvx512Vnni() {
+    static const bool supported = hasAvx512Bw() && __builtin_cpu_supports("avx512vnni");
+    return supported;
+}
+
+/**
+ * Pack B[k0:k0+kc, j0:j0+nc] in groups of `Group` consecutive k for every column:
+ * panel[(g * nc + j) * Group + t] = B[k0 + g * Group + t][j0 + j] (0 past kc),
+ * which is the operand layout of pmaddwd (Group 2) and vpdpbusd (Group 4).
+ */
+template <typename Element, int Group>
+void packGroups(const Matrix& B, int k0, int kc, int j0, int nc, Element* panel, int* colsum) {
+    const int groups = (kc + Group - 1) / Group;
+    std::fill(colsum, colsum + nc, 0);
+    for (int g = 0; g < groups; ++g) {
+        Element* dst = panel + static_cast<std::size_t>(g) * nc * Group;
+        for (int t = 0; t < Group; ++t) {
+            const int k = g * Group + t;
+            if (k < kc) {
+                const int* src = B.row(k0 + k) + j0;
+                for (int j = 0; j < nc; ++j) {
+                    dst[j * Group + t] = static_cast<Element>(src[j]);
+                    colsum[j] += src[j];
+                }
+            } else {
+                for (int j = 0; j < nc; ++j) {
+                    dst[j * Group + t] = 0;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Pack a[0:kc] in the same groups, one 32-bit word per group (the broadcast operand).
+ * With `bias` the elements are stored as unsigned bytes a + 128.
+ */
+template <typename Element, int Group>
+void packRow(const int* a, int kc, bool bias, std::uint32_t* words) {
+    const int groups = (kc + Group - 1) / Group;
+    for (int g = 0; g < groups; ++g) {
+        std::uint32_t word = 0;
+        for (int t = 0; t < Group; ++t) {
+            const int k = g * Group + t;
+            const int v = (k < kc ? a[k] : 0) + (bias ? 128 : 0);
+            word |= (static_cast<std::uint32_t>(v) & ((1u << (32 / Group)) - 1)) << (t * 32 / Group);
+        }
+        words[g] = word;
+    }
+}
+
+void rowInt16Portable(const std::uint32_t* a, int groups, const std::int16_t* panel, const int*, int nc, int* c, int j) {
+    for (; j < nc; ++j) {
+        int sum = 0;
+        for (int g = 0; g < groups; ++g) {
+            const std::int16_t* b = panel + (static_cast<std::size_t>(g) * nc + j) * 2;
+            sum += static_cast<std::int16_t>(a[g] & 0xffff) * b[0] + static_cast<std::int16_t>(a[g] >> 16) * b[1];
+        }
+        c[j] += sum;
+    }
+}
+
+__attribute__((target("avx2")))
+void rowInt16Avx2(const std::uint32_t* a, int groups, const std::int16_t* panel, const int* colsum, int nc, int* c) {
+    int j = 0;
+    for (; j + 8 <= nc; j += 8) {
+        __m256i acc = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c + j));
+        for (int g = 0; g < groups; ++g) {
+            const __m256i b = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(panel + (static_cast<std::size_t>(g) * nc + j) * 2));
+            acc = _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_set1_epi32(static_cast<int>(a[g])), b));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(c + j), acc);
+    }
+    rowInt16Portable(a, groups, panel, colsum, nc, c, j);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+void rowInt16Avx512(const std::uint32_t* a, int groups, const std::int16_t* panel, const int* colsum, int nc, int* c) {
+    int j = 0;
+    for (; j + 16 <= nc; j += 16) {
+        __m512i acc = _mm512_loadu_si512(c + j);
+        for (int g = 0; g < groups; ++g) {
+            const __m512i b = _mm512_loadu_si512(panel + (static_cast<std::size_t>(g) * nc + j) * 2);
+            acc = _mm512_add_epi32(acc, _mm512_madd_epi16(_mm512_set1_epi32(static_cast<int>(a[g])), b));
+        }
+        _mm512_storeu_si512(c + j, acc);
+    }
+    rowInt16Portable(a, groups, panel, colsum, nc, c, j);
+}
+
+void rowInt8Portable(const std::uint32_t* a, int groups, const std::int8_t* panel, const int* colsum, int nc, int* c, int j) {
+    for (; j < nc; ++j) {
+        int sum = 0;
+        for (int g = 0; g < groups; ++g) {
+            const std::int8_t* b = panel + (static_cast<std::size_t>(g) * nc + j) * 4;
+            for (int t = 0; t < 4; ++t) {
+                sum += static_cast<int>((a[g] >> (8 * t)) & 0xff) * b[t];
+            }
+        }
+        c[j] += sum - 128 * colsum[j];
+    }
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vnni")))
+void rowInt8Vnni(const std::uint32_t* a, int groups, const std::int8_t* panel, const int* colsum, int nc, int* c) {
+    // masked shift with an explicit zero source: the unmasked one passes an undefined vector
+    // that GCC 12 reports with -Wmaybe-uninitialized
+    const __m512i zero = _mm512_setzero_si512();
+    int j = 0;
+    for (; j + 16 <= nc; j += 16) {
+        __m512i acc = _mm512_loadu_si512(c + j);
+        for (int g = 0; g < groups; ++g) {
+            const __m512i b = _mm512_loadu_si512(panel + (static_cast<std::size_t>(g) * nc + j) * 4);
+            acc = _mm512_dpbusd_epi32(acc, _mm512_set1_epi32(static_cast<int>(a[g])), b);
+        }
+        // undo the +128 bias of A: sum_k 128 * b_kj
+        acc = _mm512_sub_epi32(acc, _mm512_mask_slli_epi32(zero, 0xffff, _mm512_loadu_si512(colsum + j), 7));
+        _mm512_storeu_si512(c + j, acc);
+    }
+    rowInt8Portable(a, groups, panel, colsum, nc, c, j);
+}
+
+void rowInt16Generic(const std::uint32_t* a, int groups, const std::int16_t* panel, const int* colsum, int nc, int* c) {
+    rowInt16Portable(a, groups, panel, colsum, nc, c, 0);
+}
+
+/**
+ * Same blocking and static row split as multiplyBlocked, on narrow packed panels.
+ */
+template <typename Element, int Group, typename RowKernel>
+void multiplyPacked(const Matrix& A, const Matrix& B, Matrix& C, Arena& workspace,
+                    const BlockSizes& blocks, bool biasA, RowKernel rowKernel) {
+    int maxThreads = 1;
+#ifdef _OPENMP
+    maxThreads = omp_get_max_threads();
+#endif
+    const int kcMax = std::max(std::min(blocks.kc, A.cols), 1);
+    const int ncMax = std::max(std::min(blocks.nc, B.cols), 1);
+    const std::size_t groupsMax = (kcMax + Group - 1) / Group;
+    const std::size_t panelSize = groupsMax * ncMax * Group;
+
+    Arena::Scope scratch(workspace);
+    Element* panels = workspace.allocateArray<Element>(panelSize * maxThreads);
+    std::uint32_t* words = workspace.allocateArray<std::uint32_t>(groupsMax * maxThreads);
+    int* colsums = workspace.allocateArray<int>(static_cast<std::size_t>(ncMax) * maxThreads);
+
+#pragma omp parallel num_threads(maxThreads)
+    {
+        int threads = 1, tid = 0;
+#ifdef _OPENMP
+        threads = omp_get_num_threads();
+        tid = omp_get_thread_num();
+#endif
+        int begin, end;
+        blockRange(A.rows, threads, tid, begin, end);
+        Matrix myC = rowBlock(C, begin, end - begin);
+        fillMatrix(myC, 0);
+        Element* panel = panels + panelSize * tid;
+        std::uint32_t* word = words + groupsMax * tid;
+        int* colsum = colsums + static_cast<std::size_t>(ncMax) * tid;
+
+        if (begin < end) {
+            for (int j0 = 0; j0 < B.cols; j0 += blocks.nc) {
+                const int nc = std::min(blocks.nc, B.cols - j0);
+                for (int k0 = 0; k0 < A.cols; k0 += blocks.kc) {
+                    const int kc = std::min(blocks.kc, A.cols - k0);
+                    const int groups = (kc + Group - 1) / Group;
+                    packGroups<Element, Group>(B, k0, kc, j0, nc, panel, colsum);
+                    for (int i = begin; i < end; ++i) {
+                        packRow<Element, Group>(A.row(i) + k0, kc, biasA, word);
+                        rowKernel(word, groups, panel, colsum, nc, C.row(i) + j0);
+                    }
+                }
+            }
+        }
+    }
+}
+
+}
+
+ValueRange scanRange(const Matrix& M) {
+    if (M.rows == 0 || M.cols == 0) {
+        return {0, 0};
+    }
+    int lo = INT_MAX, hi = INT_MIN;
+#pragma omp parallel for reduction(min : lo) reduction(max : hi)
+    for (int i = 0; i < M.rows; ++i) {
+        const int* r = M.row(i);
+        for (int j = 0; j < M.cols; ++j) {
+            lo = std::min(lo, r[j]);
+            hi = std::max(hi, r[j]);
+        }
+    }
+    return {lo, hi};
+}
+
+QuantizedWidth quantizedWidth(ValueRange a, ValueRange b) {
+    const int lo = std::min(a.min, b.min);
+    const int hi = std::max(a.max, b.max);
+    if (lo >= INT8_MIN && hi <= INT8_MAX) {
+        return QuantizedWidth::Int8;
+    }
+    if (lo >= INT16_MIN && hi <= INT16_MAX) {
+        return QuantizedWidth::Int16;
+    }
+    return QuantizedWidth::Int32;
+}
+
+void multiplyInt16(const Matrix& A, const Matrix& B, Matrix& C, Arena& workspace, const BlockSizes& blocks) {
+    if (hasAvx512Bw()) {
+        multiplyPacked<std::int16_t, 2>(A, B, C, workspace, blocks, false, rowInt16Avx512);
+    } else if (hasAvx2()) {
+        multiplyPacked<std::int16_t, 2>(A, B, C, workspace, blocks, false, rowInt16Avx2);
+    } else {
+        multiplyPacked<std::int16_t, 2>(A, B, C, workspace, blocks, false, rowInt16Generic);
+    }
+}
+
+void multiplyInt8(const Matrix& A, const Matrix& B, Matrix& C, Arena& workspace, const BlockSizes& blocks) {
+    if (hasAvx512Vnni()) {
+        multiplyPacked<std::int8_t, 4>(A, B, C, workspace, blocks, true, rowInt8Vnni);
+    } else {
+        // pmaddubsw saturates its 16-bit pair sums, widen to int16 instead
+        multiplyInt16(A, B, C, workspace, blocks);
+    }
+}
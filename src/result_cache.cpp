@@ -0,0 +1,216 @@
+#include "result_cache.h"
+#include "hash.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <utility>
+#include <ostream>
+#include <vector>
+
+namespace {
+
+constexpr char kMagic[8] = {'M', 'M', 'C', 'A', 'C', 'H', 'E', '1'};
+constexpr const char* kEntrySuffix = ".mat";
+constexpr const char* kTempMarker = ".tmp.";
+// temporary files older than this belong to a writer that died
+constexpr std::time_t kStaleTempSeconds = 3600;
+
+void hashOperand(Hash64& hash, const Matrix& M) {
+    const int dims[2] = {M.rows, M.cols};
+    hash.update(dims, sizeof(dims));
+    for (int i = 0; i < M.rows; ++i) {
+        hash.update(M.row(i), static_cast<std::size_t>(M.cols) * sizeof(int));
+    }
+}
+
+bool endsWith(const std::string& s, const char* suffix) {
+    const std::size_t n = std::strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+/**
+ * Exclusive fcntl lock held for the lifetime of the object.
+ */
+class DirectoryLock {
+public:
+    explicit DirectoryLock(const std::string& path) {
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0666);
+        if (fd_ >= 0) {
+            struct flock lock = {};
+            lock.l_type = F_WRLCK;
+            lock.l_whence = SEEK_SET;
+            while (fcntl(fd_, F_SETLKW, &lock) != 0 && errno == EINTR) {
+            }
+        }
+    }
+    ~DirectoryLock() {
+        if (fd_ >= 0) {
+            ::close(fd_); // closing releases the lock
+        }
+    }
+    bool locked() const { return fd_ >= 0; }
+
+private:
+    int fd_ = -1;
+};
+
+}
+
+std::string CacheKey::hex() const {
+    char buffer[33];
+    std::snprintf(buffer, sizeof(buffer), "%016llx%016llx",
+                  static_cast<unsigned long long>(high), static_cast<unsigned long long>(low));
+    return buffer;
+}
+
+CacheKey operandKey(const Matrix& A, const Matrix& B, std::uint32_t modulus, SemiringKind semiring) {
+    Hash64 high(0x6d61747269784131ULL), low(0x6d61747269784232ULL);
+    hashOperand(high, A);
+    hashOperand(high, B);
+    hashOperand(low, A);
+    hashOperand(low, B);
+    if (modulus != 0) {
+        high.update(&modulus, sizeof(modulus));
+        low.update(&modulus, sizeof(modulus));
+    }
+    if (semiring != SemiringKind::PlusTimes) {
+        const std::int32_t tag = static_cast<std::int32_t>(semiring);
+        high.update(&tag, sizeof(tag));
+        low.update(&tag, sizeof(tag));
+    }
+    CacheKey key;
+    key.high = high.digest();
+    key.low = low.digest();
+    return key;
+}
+
+bool CachedResult::stream(std::ostream& out) {
+    std::vector<int> row(cols);
+    for (int i = 0; i < rows; ++i) {
+        if (!in.read(reinterpret_cast<char*>(row.data()), static_cast<std::streamsize>(cols) * sizeof(int))) {
+            return false;
+        }
+        for (int j = 0; j < cols; ++j) {
+            out << row[j] << " ";
+        }
+        out << '\n';
+    }
+    out.flush();
+    return true;
+}
+
+ResultCache::ResultCache(std::string directory, std::uint64_t maxBytes)
+    : directory_(std::move(directory)), maxBytes_(maxBytes) {
+    mkdir(directory_.c_str(), 0777);
+}
+
+std::string ResultCache::entryPath(const CacheKey& key) const {
+    return directory_ + "/" + key.hex() + kEntrySuffix;
+}
+
+bool ResultCache::open(const CacheKey& key, CachedResult& result) {
+    const std::string path = entryPath(key);
+    result.in.open(path, std::ios::binary);
+    char magic[sizeof(kMagic)];
+    int dims[2];
+    if (!result.in || !result.in.read(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+        !result.in.read(reinterpret_cast<char*>(dims), sizeof(dims)) || dims[0] < 0 || dims[1] < 0) {
+        result.in.close();
+        ++stats_.misses;
+        return false;
+    }
+    result.rows = dims[0];
+    result.cols = dims[1];
+    // the mtime is the LRU recency
+    utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+    ++stats_.hits;
+    return true;
+}
+
+bool ResultCache::store(const CacheKey& key, const Matrix& C) {
+    char host[256] = "host";
+    gethostname(host, sizeof(host) - 1);
+    const std::string final = entryPath(key);
+    const std::string temp = final + kTempMarker + host + "." + std::to_string(getpid());
+
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        const int dims[2] = {C.rows, C.cols};
+        out.write(kMagic, sizeof(kMagic));
+        out.write(reinterpret_cast<const char*>(dims), sizeof(dims));
+        for (int i = 0; i < C.rows; ++i) {
+            out.write(reinterpret_cast<const char*>(C.row(i)), static_cast<std::streamsize>(C.cols) * sizeof(int));
+        }
+        out.flush();
+        if (!out) {
+            std::remove(temp.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temp.c_str(), final.c_str()) != 0) {
+        std::remove(temp.c_str());
+        return false;
+    }
+    ++stats_.stores;
+    return true;
+}
+
+void ResultCache::evict() {
+    DirectoryLock lock(directory_ + "/.lock");
+    if (!lock.locked()) {
+        return;
+    }
+
+    struct Entry {
+        std::string path;
+        std::uint64_t bytes;
+        struct timespec mtime;
+    };
+    std::vector<Entry> entries;
+    std::uint64_t total = 0;
+    const std::time_t now = std::time(nullptr);
+
+    DIR* dir = opendir(directory_.c_str());
+    if (dir == nullptr) {
+        return;
+    }
+    while (dirent* item = readdir(dir)) {
+        const std::string name = item->d_name;
+        const std::string path = directory_ + "/" + name;
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+        if (name.find(kTempMarker) != std::string::npos) {
+            if (now - st.st_mtime > kStaleTempSeconds) {
+                std::remove(path.c_str());
+            }
+        } else if (endsWith(name, kEntrySuffix)) {
+            entries.push_back({path, static_cast<std::uint64_t>(st.st_size), st.st_mtim});
+            total += static_cast<std::uint64_t>(st.st_size);
+        }
+    }
+    closedir(dir);
+
+    if (total <= maxBytes_) {
+        return;
+    }
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.mtime.tv_sec != b.mtime.tv_sec ? a.mtime.tv_sec < b.mtime.tv_sec : a.mtime.tv_nsec < b.mtime.tv_nsec;
+    });
+    for (const Entry& entry : entries) {
+        if (total <= maxBytes_) {
+            break;
+        }
+        if (std::remove(entry.path.c_str()) == 0) {
+            total -= entry.bytes;
+            ++stats_.evictions;
+        }
+    }
+}
@@ -0,0 +1,252 @@
+#include "semiring.h"
+#include <immintrin.h>
+#include <algorithm>
+#include <cstring>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+
+bool hasAvx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+bool hasAvx512() {
+    static const bool supported = __builtin_cpu_supports("avx512f");
+    return supported;
+}
+
+/**
+ * c[j] = add(c[j], mul(a, b[j])) for j in [from, n), a != S::zero().
+ */
+template <typename S>
+void updateRowPortable(int* c, int a, const int* b, int from, int n) {
+#pragma omp simd
+    for (int j = from; j < n; ++j) {
+        c[j] = S::add(c[j], S::mul(a, b[j]));
+    }
+}
+
+/**
+ * Lane-wise min and max with an explicit zero source: the unmasked intrinsics pass an
+ * undefined vector that GCC 12 reports with -Wmaybe-uninitialized.
+ */
+__attribute__((target("avx512f")))
+__m512i minLanes(__m512i x, __m512i y) {
+    return _mm512_mask_min_epi32(_mm512_setzero_si512(), 0xffff, x, y);
+}
+
+__attribute__((target("avx512f")))
+__m512i maxLanes(__m512i x, __m512i y) {
+    return _mm512_mask_max_epi32(_mm512_setzero_si512(), 0xffff, x, y);
+}
+
+/**
+ * One vector of the row update per semiring, 16 lanes (AVX-512) and 8 lanes (AVX2).
+ * `a` is never zero here, so mul only has to absorb the zeros of b.
+ */
+template <typename S>
+struct Lanes;
+
+template <>
+struct Lanes<PlusTimes> {
+    __attribute__((target("avx512f")))
+    static __m512i update(__m512i c, __m512i a, __m512i b) { return _mm512_add_epi32(c, _mm512_mullo_epi32(a, b)); }
+    __attribute__((target("avx2")))
+    static __m256i update(__m256i c, __m256i a, __m256i b) { return _mm256_add_epi32(c, _mm256_mullo_epi32(a, b)); }
+};
+
+template <>
+struct Lanes<MinPlus> {
+    __attribute__((target("avx512f")))
+    static __m512i update(__m512i c, __m512i a, __m512i b) {
+        const __mmask16 infinite = _mm512_cmpeq_epi32_mask(b, _mm512_set1_epi32(MinPlus::zero()));
+        return minLanes(c, _mm512_mask_mov_epi32(_mm512_add_epi32(a, b), infinite, b));
+    }
+    __attribute__((target("avx2")))
+    static __m256i update(__m256i c, __m256i a, __m256i b) {
+        const __m256i infinite = _mm256_cmpeq_epi32(b, _mm256_set1_epi32(MinPlus::zero()));
+        return _mm256_min_epi32(c, _mm256_blendv_epi8(_mm256_add_epi32(a, b), b, infinite));
+    }
+};
+
+template <>
+struct Lanes<MaxPlus> {
+    __attribute__((target("avx512f")))
+    static __m512i update(__m512i c, __m512i a, __m512i b) {
+        const __mmask16 infinite = _mm512_cmpeq_epi32_mask(b, _mm512_set1_epi32(MaxPlus::zero()));
+        return maxLanes(c, _mm512_mask_mov_epi32(_mm512_add_epi32(a, b), infinite, b));
+    }
+    __attribute__((target("avx2")))
+    static __m256i update(__m256i c, __m256i a, __m256i b) {
+        const __m256i infinite = _mm256_cmpeq_epi32(b, _mm256_set1_epi32(MaxPlus::zero()));
+        return _mm256_max_epi32(c, _mm256_blendv_epi8(_mm256_add_epi32(a, b), b, infinite));
+    }
+};
+
+template <>
+struct Lanes<MaxMin> {
+    __attribute__((target("avx512f")))
+    static __m512i update(__m512i c, __m512i a, __m512i b) { return maxLanes(c, minLanes(a, b)); }
+    __attribute__((target("avx2")))
+    static __m256i update(__m256i c, __m256i a, __m256i b) { return _mm256_max_epi32(c, _mm256_min_epi32(a, b)); }
+};
+
+template <typename S>
+__attribute__((target("avx512f")))
+void updateRowAvx512(int* c, int a, const int* b, int n) {
+    const __m512i va = _mm512_set1_epi32(a);
+    int j = 0;
+    for (; j + 16 <= n; j += 16) {
+        _mm512_storeu_si512(c + j, Lanes<S>::update(_mm512_loadu_si512(c + j), va, _mm512_loadu_si512(b + j)));
+    }
+    updateRowPortable<S>(c, a, b, j, n);
+}
+
+template <typename S>
+__attribute__((target("avx2")))
+void updateRowAvx2(int* c, int a, const int* b, int n) {
+    const __m256i va = _mm256_set1_epi32(a);
+    int j = 0;
+    for (; j + 8 <= n; j += 8) {
+        const __m256i vc = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c + j));
+        const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + j));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(c + j), Lanes<S>::update(vc, va, vb));
+    }
+    updateRowPortable<S>(c, a, b, j, n);
+}
+
+template <typename S>
+void updateRow(int* c, int a, const int* b, int n) {
+    updateRowPortable<S>(c, a, b, 0, n);
+}
+
+}
+
+template <typename S>
+void multiplySemiring(const Matrix& A, const Matrix& B, Matrix& C, Arena& workspace, const BlockSizes& blocks) {
+    void (*update)(int*, int, const int*, int) =
+        hasAvx512() ? updateRowAvx512<S> : hasAvx2() ? updateRowAvx2<S> : updateRow<S>;
+    int maxThreads = 1;
+#ifdef _OPENMP
+    maxThreads = omp_get_max_threads();
+#endif
+    Arena::Scope scratch(workspace);
+    const std::size_t panelSize =
+        static_cast<std::size_t>(std::max(std::min(blocks.kc, A.cols), 1)) * std::max(std::min(blocks.nc, B.cols), 1);
+    int* panels = workspace.allocateArray<int>(panelSize * maxThreads);
+
+#pragma omp parallel num_threads(maxThreads)
+    {
+        int threads = 1, tid = 0;
+#ifdef _OPENMP
+        threads = omp_get_num_threads();
+        tid = omp_get_thread_num();
+#endif
+        int begin, end;
+        blockRange(A.rows, threads, tid, begin, end);
+        Matrix myC = rowBlock(C, begin, end - begin);
+        fillMatrix(myC, S::zero());
+        int* panel = panels + panelSize * tid;
+
+        for (int j0 = 0; begin < end && j0 < B.cols; j0 += blocks.nc) {
+            const int nc = std::min(blocks.nc, B.cols - j0);
+            for (int k0 = 0; k0 < A.cols; k0 += blocks.kc) {
+                const int kc = std::min(blocks.kc, A.cols - k0);
+                for (int k = 0; k < kc; ++k) {
+                    const int* src = B.row(k0 + k) + j0;
+                    std::copy(src, src + nc, panel + static_cast<std::size_t>(k) * nc);
+                }
+                for (int i = begin; i < end; ++i) {
+                    const int* a = A.row(i) + k0;
+                    int* c = C.row(i) + j0;
+                    for (int k = 0; k < kc; ++k) {
+                        if (a[k] != S::zero()) {
+                            update(c, a[k], panel + static_cast<std::size_t>(k) * nc, nc);
+                        }
+                    }
+                }
+            }
+        }
+        // like the other kernels, the padding of C holds 0 whatever the semiring
+        for (int i = begin; i < end; ++i) {
+            std::fill(C.row(i) + C.cols, C.row(i) + C.span(), 0);
+        }
+    }
+}
+
+template void multiplySemiring<PlusTimes>(const Matrix&, const Matrix&, Matrix&, Arena&, const BlockSizes&);
+template void multiplySemiring<MinPlus>(const Matrix&, const Matrix&, Matrix&, Arena&, const BlockSizes&);
+template void multiplySemiring<MaxPlus>(const Matrix&, const Matrix&, Matrix&, Arena&, const BlockSizes&);
+template void multiplySemiring<MaxMin>(const Matrix&, const Matrix&, Matrix&, Arena&, const BlockSizes&);
+
+bool parseSemiringKind(const char* name, SemiringKind& kind) {
+    static const SemiringKind kinds[] = {SemiringKind::PlusTimes, SemiringKind::MinPlus,
+                                         SemiringKind::MaxPlus, SemiringKind::MaxMin};
+    for (SemiringKind k : kinds) {
+        if (std::strcmp(name, semiringName(k)) == 0) {
+            kind = k;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* semiringName(SemiringKind kind) {
+    switch (kind) {
+    case SemiringKind::MinPlus:
+        return MinPlus::name;
+    case SemiringKind::MaxPlus:
+        return MaxPlus::name;
+    case SemiringKind::MaxMin:
+        return MaxMin::name;
+    default:
+        return PlusTimes::name;
+    }
+}
+
+int semiringZero(SemiringKind kind) {
+    switch (kind) {
+    case SemiringKind::MinPlus:
+        return MinPlus::zero();
+    case SemiringKind::MaxPlus:
+        return MaxPlus::zero();
+    case SemiringKind::MaxMin:
+        return MaxMin::zero();
+    default:
+        return PlusTimes::zero();
+    }
+}
+
+int semiringOne(SemiringKind kind) {
+    switch (kind) {
+    case SemiringKind::MinPlus:
+        return MinPlus::one();
+    case SemiringKind::MaxPlus:
+        return MaxPlus::one();
+    case SemiringKind::MaxMin:
+        return MaxMin::one();
+    default:
+        return PlusTimes::one();
+    }
+}
+
+void multiplySemiring(SemiringKind kind, const Matrix& A, const Matrix& B, Matrix& C, Arena& workspace,
+                      const BlockSizes& blocks) {
+    switch (kind) {
+    case SemiringKind::MinPlus:
+        multiplySemiring<MinPlus>(A, B, C, workspace, blocks);
+        break;
+    case SemiringKind::MaxPlus:
+        multiplySemiring<MaxPlus>(A, B, C, workspace, blocks);
+        break;
+    case SemiringKind::MaxMin:
+        multiplySemiring<MaxMin>(A, B, C, workspace, blocks);
+        break;
+    default:
+        multiplySemiring<PlusTimes>(A, B, C, workspace, blocks);
+        break;
+    }
+}
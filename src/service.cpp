@@ -0,0 +1,161 @@
+#include "service.h"
+#include "distributed.h"
+#include "matrix.h"
+#include "service_protocol.h"
+#include <sys/socket.h>
+#include <unistd.h>
+#include <exception>
+#include <iostream>
+#include <string>
+
+namespace {
+
+enum Command : int {
+    kStop = 0,
+    kMultiply = 1,
+};
+
+// a client that stops sending (or reading) in the middle of a request is dropped after this
+constexpr int kClientTimeoutMilliseconds = 30000;
+
+void reply(int fd, const std::string& message) {
+    sendU32(fd, static_cast<std::uint32_t>(ResponseStatus::Error));
+    sendString(fd, message);
+}
+
+/**
+ * Read one request on rank 0.
+ * @return false (after replying to the client) if the request cannot be served.
+ */
+bool readRequest(int fd, Arena& storage, RequestType& type, Matrix& A, Matrix& B) {
+    std::uint32_t magic, rawType;
+    if (!recvU32(fd, magic) || magic != kRequestMagic || !recvU32(fd, rawType)) {
+        reply(fd, "malformed request");
+        return false;
+    }
+    type = static_cast<RequestType>(rawType);
+    switch (type) {
+    case RequestType::Shutdown:
+        return true;
+    case RequestType::Paths: {
+        std::string pathA, pathB;
+        if (!recvString(fd, pathA) || !recvString(fd, pathB)) {
+            reply(fd, "malformed request");
+            return false;
+        }
+        if (!readMatrixFromFile(pathA, storage, A)) {
+            reply(fd, "Error opening file: " + pathA);
+            return false;
+        }
+        if (!readMatrixFromFile(pathB, storage, B)) {
+            reply(fd, "Error opening file: " + pathB);
+            return false;
+        }
+        break;
+    }
+    case RequestType::Inline:
+        if (!recvMatrix(fd, storage, A) || !recvMatrix(fd, storage, B)) {
+            reply(fd, "malformed request");
+            return false;
+        }
+        break;
+    default:
+        reply(fd, "unknown request type");
+        return false;
+    }
+    if (A.cols != B.rows) {
+        reply(fd, "the number of columns of A differs from the number of rows of B");
+        return false;
+    }
+    if (!matrixFits(A.rows, B.cols)) {
+        reply(fd, "the product is too large");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * readRequest, with a failure to allocate or read the operands answered like a bad request.
+ */
+bool serveRequest(int fd, Arena& storage, RequestType& type, Matrix& A, Matrix& B) {
+    try {
+        return readRequest(fd, storage, type, A, B);
+    } catch (const std::exception& e) {
+        reply(fd, std::string("request failed: ") + e.what());
+        return false;
+    }
+}
+
+}
+
+int runService(const std::string& socketPath, MPI_Comm comm,
+               Arena& storage, Arena& workspace, const DistributedOptions& options) {
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+
+    int listener = -1;
+    int ok = 1;
+    if (rank == 0) {
+        listener = listenOnSocket(socketPath);
+        if (listener < 0) {
+            std::cerr << "Error opening socket: " << socketPath << std::endl;
+            ok = 0;
+        } else {
+            std::cerr << "[service] listening on " << socketPath << std::endl;
+        }
+    }
+    MPI_Bcast(&ok, 1, MPI_INT, 0, comm);
+    if (!ok) {
+        return 1;
+    }
+
+    long jobs = 0;
+    for (;;) {
+        int command = kMultiply;
+        int client = -1;
+        Matrix A, B;
+        if (rank == 0) {
+            // serve until a valid request arrives, bad ones are answered here and never reach the workers
+            for (;;) {
+                client = accept(listener, nullptr, nullptr);
+                if (client < 0) {
+                    continue;
+                }
+                setSocketTimeout(client, kClientTimeoutMilliseconds);
+                RequestType type;
+                if (serveRequest(client, storage, type, A, B)) {
+                    command = type == RequestType::Shutdown ? kStop : kMultiply;
+                    break;
+                }
+                close(client);
+                storage.reset();
+            }
+        }
+        MPI_Bcast(&command, 1, MPI_INT, 0, comm);
+        if (command == kStop) {
+            if (rank == 0) {
+                sendU32(client, static_cast<std::uint32_t>(ResponseStatus::Ok));
+                close(client);
+            }
+            break;
+        }
+
+        const double start = MPI_Wtime();
+        Matrix C = distributedMultiply(A, B, comm, storage, workspace, options);
+        if (rank == 0) {
+            sendU32(client, static_cast<std::uint32_t>(ResponseStatus::Ok));
+            sendMatrix(client, C);
+            close(client);
+            std::cerr << "[service] job " << ++jobs << ": " << A.rows << "x" << A.cols << " * "
+                      << B.rows << "x" << B.cols << " in " << MPI_Wtime() - start << " s" << std::endl;
+        }
+        storage.reset();
+        workspace.reset();
+    }
+
+    if (rank == 0) {
+        close(listener);
+        unlink(socketPath.c_str());
+    }
+    return 0;
+}
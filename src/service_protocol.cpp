@@ -0,0 +1,159 @@
+#include "service_protocol.h"
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+bool makeAddress(const std::string& path, sockaddr_un& address) {
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+}
+
+bool writeAll(int fd, const void* data, std::size_t bytes) {
+    const char* p = static_cast<const char*>(data);
+    while (bytes > 0) {
+        // MSG_NOSIGNAL: a client that went away must not kill the service with SIGPIPE
+        ssize_t n = send(fd, p, bytes, MSG_NOSIGNAL);
+        if (n < 0 && errno == ENOTSOCK) {
+            n = write(fd, p, bytes);
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        bytes -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+bool readAll(int fd, void* data, std::size_t bytes) {
+    char* p = static_cast<char*>(data);
+    while (bytes > 0) {
+        ssize_t n = read(fd, p, bytes);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        bytes -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+bool sendU32(int fd, std::uint32_t value) {
+    return writeAll(fd, &value, sizeof(value));
+}
+
+bool recvU32(int fd, std::uint32_t& value) {
+    return readAll(fd, &value, sizeof(value));
+}
+
+bool sendString(int fd, const std::string& s) {
+    return sendU32(fd, static_cast<std::uint32_t>(s.size())) && writeAll(fd, s.data(), s.size());
+}
+
+bool recvString(int fd, std::string& s, std::size_t maxLength) {
+    std::uint32_t length;
+    if (!recvU32(fd, length) || length > maxLength) {
+        return false;
+    }
+    s.resize(length);
+    return readAll(fd, &s[0], length);
+}
+
+bool sendMatrix(int fd, const Matrix& M) {
+    const std::int32_t dims[2] = {M.rows, M.cols};
+    if (!writeAll(fd, dims, sizeof(dims))) {
+        return false;
+    }
+    for (int i = 0; i < M.rows; ++i) {
+        if (!writeAll(fd, M.row(i), static_cast<std::size_t>(M.cols) * sizeof(int))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool matrixFits(std::int64_t rows, std::int64_t cols, std::size_t maxElements) {
+    if (rows < 0 || cols < 0 || cols > std::numeric_limits<int>::max() - static_cast<std::int64_t>(Arena::kAlignment) ||
+        static_cast<std::uint64_t>(cols) > maxElements) {
+        return false;
+    }
+    const std::uint64_t stride = static_cast<std::uint64_t>(paddedStride(static_cast<int>(cols)));
+    return rows == 0 || stride <= maxElements / static_cast<std::uint64_t>(rows);
+}
+
+bool recvMatrix(int fd, Arena& arena, Matrix& M, std::size_t maxElements) {
+    std::int32_t dims[2];
+    if (!readAll(fd, dims, sizeof(dims)) || !matrixFits(dims[0], dims[1], maxElements)) {
+        return false;
+    }
+    M = allocateMatrix(arena, dims[0], dims[1]);
+    for (int i = 0; i < M.rows; ++i) {
+        int* r = M.row(i);
+        if (!readAll(fd, r, static_cast<std::size_t>(M.cols) * sizeof(int))) {
+            return false;
+        }
+        std::fill(r + M.cols, r + M.stride, 0);
+    }
+    return true;
+}
+
+bool setSocketTimeout(int fd, int milliseconds) {
+    timeval timeout;
+    timeout.tv_sec = milliseconds / 1000;
+    timeout.tv_usec = (milliseconds % 1000) * 1000;
+    return setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) == 0 &&
+           setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) == 0;
+}
+
+int listenOnSocket(const std::string& path) {
+    sockaddr_un address;
+    if (!makeAddress(path, address)) {
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, 16) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int connectToSocket(const std::string& path) {
+    sockaddr_un address;
+    if (!makeAddress(path, address)) {
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
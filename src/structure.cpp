@@ -0,0 +1,343 @@
+#include "structure.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstring>
+
+namespace {
+
+constexpr int kSymmetricTile = 32;
+constexpr int kBandedRows = 4;
+constexpr int kBandedColumns = 512;
+// use the banded kernel only if it is left with at most this fraction of the dense work: the
+// int8 and int16 kernels do the full product about 4x faster than its int32 row updates
+constexpr double kBandedMaxWork = 0.6;
+constexpr double kBandedMaxWorkQuantized = 0.15;
+// a row update (loop setup, unaligned ends) costs about as much as this many more elements
+constexpr int kBandedRowCost = 32;
+
+bool isSymmetric(const Matrix& M) {
+    bool symmetric = true;
+#pragma omp parallel for schedule(dynamic, 16)
+    for (int i = 0; i < M.rows; ++i) {
+        if (!symmetric) {
+            continue;
+        }
+        const int* r = M.row(i);
+        for (int j = i + 1; j < M.cols; ++j) {
+            if (r[j] != M.at(j, i)) {
+                symmetric = false;
+                break;
+            }
+        }
+    }
+    return symmetric;
+}
+
+void kRange(const MatrixStructure& sa, int globalRow, int colsA, int& kLo, int& kHi) {
+    kLo = std::max(0, globalRow - sa.lowerBandwidth);
+    kHi = std::min(colsA - 1, globalRow + sa.upperBandwidth);
+}
+
+void jRange(const MatrixStructure& sb, int k, int colsB, int& jLo, int& jHi) {
+    jLo = std::max(0, k - sb.lowerBandwidth);
+    jHi = std::min(colsB - 1, k + sb.upperBandwidth);
+}
+
+/**
+ * Fraction of the dense k x j work left once the known-zero parts of the bands are skipped,
+ * every row update counted kBandedRowCost elements longer than it is.
+ */
+double bandedWork(const Matrix& A, const Matrix& B, const MatrixStructure& sa, const MatrixStructure& sb) {
+    if (A.rows == 0 || A.cols == 0 || B.cols == 0) {
+        return 1.0;
+    }
+    double kWork = 0, jWork = 0;
+    for (int i = 0; i < A.rows; ++i) {
+        int kLo, kHi;
+        kRange(sa, i + sa.rowOffset, A.cols, kLo, kHi);
+        kWork += std::max(0, kHi - kLo + 1);
+    }
+    for (int k = 0; k < B.rows; ++k) {
+        int jLo, jHi;
+        jRange(sb, k, B.cols, jLo, jHi);
+        jWork += std::min(B.cols, std::max(0, jHi - jLo + 1) + kBandedRowCost);
+    }
+    return (kWork / (static_cast<double>(A.rows) * A.cols)) * (jWork / (static_cast<double>(B.rows) * B.cols));
+}
+
+/**
+ * c[j] += a * b[j] for j in [0, n), compiled for AVX-512, for AVX2 and for the baseline ISA
+ * (whose vector multiply of 32-bit lanes is too slow to beat the dense kernels).
+ */
+__attribute__((target("avx512f")))
+void addScaledRowAvx512(int* c, int a, const int* b, int n) {
+#pragma omp simd
+    for (int j = 0; j < n; ++j) {
+        c[j] += a * b[j];
+    }
+}
+
+__attribute__((target("avx2")))
+void addScaledRowAvx2(int* c, int a, const int* b, int n) {
+#pragma omp simd
+    for (int j = 0; j < n; ++j) {
+        c[j] += a * b[j];
+    }
+}
+
+void addScaledRow(int* c, int a, const int* b, int n) {
+#pragma omp simd
+    for (int j = 0; j < n; ++j) {
+        c[j] += a * b[j];
+    }
+}
+
+/**
+ * Groups of kBandedRows rows of A, kBandedColumns columns of C at a time: every row of B in
+ * the bands of the group is read once per column tile and added, in L1, to all the rows of
+ * C of the group that need it.
+ */
+void multiplyBanded(const Matrix& A, const Matrix& B, Matrix& C, const MatrixStructure& sa, const MatrixStructure& sb) {
+    void (*addScaled)(int*, int, const int*, int) = __builtin_cpu_supports("avx512f") ? addScaledRowAvx512
+                                                    : __builtin_cpu_supports("avx2")  ? addScaledRowAvx2
+                                                                                      : addScaledRow;
+    const int groups = (A.rows + kBandedRows - 1) / kBandedRows;
+#pragma omp parallel for schedule(static)
+    for (int g = 0; g < groups; ++g) {
+        const int i0 = g * kBandedRows;
+        const int rows = std::min(kBandedRows, A.rows - i0);
+        const int* a[kBandedRows];
+        int* c[kBandedRows];
+        int kLo[kBandedRows], kHi[kBandedRows];
+        int kFirst = INT_MAX, kLast = INT_MIN;
+        for (int r = 0; r < rows; ++r) {
+            a[r] = A.row(i0 + r);
+            c[r] = C.row(i0 + r);
+            std::fill(c[r], c[r] + C.span(), 0);
+            kRange(sa, i0 + r + sa.rowOffset, A.cols, kLo[r], kHi[r]);
+            kFirst = std::min(kFirst, kLo[r]);
+            kLast = std::max(kLast, kHi[r]);
+        }
+        for (int j0 = 0; j0 < B.cols; j0 += kBandedColumns) {
+            const int j1 = std::min(B.cols, j0 + kBandedColumns);
+            for (int k = kFirst; k <= kLast; ++k) {
+                int jLo, jHi;
+                jRange(sb, k, B.cols, jLo, jHi);
+                jLo = std::max(jLo, j0);
+                jHi = std::min(jHi, j1 - 1);
+                const int* b = B.row(k);
+                for (int r = 0; r < rows; ++r) {
+                    const int aik = k >= kLo[r] && k <= kHi[r] ? a[r][k] : 0;
+                    if (aik == 0) {
+                        continue;
+                    }
+                    if (jLo <= jHi) {
+                        addScaled(c[r] + jLo, aik, b + jLo, jHi - jLo + 1);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * C = A * A with A symmetric: column j of A is row j, so C[i][j] = dot(row i, row j)
+ * and only the tiles of the upper triangle of C are computed, the lower one is mirrored.
+ */
+void multiplySymmetricSquare(const Matrix& A, Matrix& C) {
+    const int n = A.rows;
+    const int tiles = (n + kSymmetricTile - 1) / kSymmetricTile;
+#pragma omp parallel for schedule(dynamic, 1)
+    for (int pair = 0; pair < tiles * tiles; ++pair) {
+        const int ti = pair / tiles, tj = pair % tiles;
+        if (tj < ti) {
+            continue;
+        }
+        const int iEnd = std::min(n, (ti + 1) * kSymmetricTile);
+        const int jEnd = std::min(n, (tj + 1) * kSymmetricTile);
+        for (int i = ti * kSymmetricTile; i < iEnd; ++i) {
+            const int* ri = A.row(i);
+            for (int j = std::max(i, tj * kSymmetricTile); j < jEnd; ++j) {
+                const int* rj = A.row(j);
+                int sum = 0;
+                for (int k = 0; k < n; ++k) {
+                    sum += ri[k] * rj[k];
+                }
+                C.at(i, j) = sum;
+                C.at(j, i) = sum;
+            }
+        }
+    }
+    for (int i = 0; i < n; ++i) {
+        std::fill(C.row(i) + C.cols, C.row(i) + C.span(), 0);
+    }
+}
+
+bool sameContents(const Matrix& A, const Matrix& B) {
+    if (A.data == B.data) {
+        return true;
+    }
+    for (int i = 0; i < A.rows; ++i) {
+        if (std::memcmp(A.row(i), B.row(i), static_cast<std::size_t>(A.cols) * sizeof(int)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+MatrixStructure detectStructure(const Matrix& M, int rowOffset) {
+    const auto start = std::chrono::steady_clock::now();
+    MatrixStructure s;
+    s.rowOffset = rowOffset;
+
+    int lo = INT_MAX, hi = INT_MIN;
+    int lower = INT_MIN, upper = INT_MIN;
+    bool unitDiagonal = true;
+#pragma omp parallel for reduction(min : lo) reduction(max : hi, lower, upper) reduction(&& : unitDiagonal)
+    for (int i = 0; i < M.rows; ++i) {
+        const int* r = M.row(i);
+        const int gi = i + rowOffset;
+        unitDiagonal = unitDiagonal && gi < M.cols && r[gi] == 1;
+        int first = -1, last = -1;
+        for (int j = 0; j < M.cols; ++j) {
+            const int v = r[j];
+            lo = std::min(lo, v);
+            hi = std::max(hi, v);
+            if (v != 0) {
+                last = j;
+                if (first < 0) {
+                    first = j;
+                }
+            }
+        }
+        if (first >= 0) {
+            lower = std::max(lower, gi - first);
+            upper = std::max(upper, last - gi);
+        }
+    }
+
+    if (M.rows == 0 || M.cols == 0) {
+        lo = hi = 0;
+    }
+    s.range = {lo, hi};
+    if (lower == INT_MIN) {
+        // no nonzero at all: an empty band
+        s.flags |= kZero | kDiagonal | kLowerTriangular | kUpperTriangular;
+        s.lowerBandwidth = s.upperBandwidth = -M.cols - M.rows - rowOffset;
+    } else {
+        s.lowerBandwidth = lower;
+        s.upperBandwidth = upper;
+        if (upper <= 0) {
+            s.flags |= kLowerTriangular;
+        }
+        if (lower <= 0) {
+            s.flags |= kUpperTriangular;
+        }
+        if (upper <= 0 && lower <= 0) {
+            s.flags |= kDiagonal;
+            if (unitDiagonal) {
+                s.flags |= kIdentity;
+            }
+        }
+    }
+    if (rowOffset == 0 && M.rows == M.cols && !s.is(kDiagonal) && isSymmetric(M)) {
+        s.flags |= kSymmetric;
+    }
+
+    s.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return s;
+}
+
+std::string describeStructure(const MatrixStructure& s, int cols) {
+    if (s.is(kZero)) {
+        return "zero";
+    }
+    if (s.is(kIdentity)) {
+        return "identity";
+    }
+    if (s.is(kDiagonal)) {
+        return "diagonal";
+    }
+    std::string description;
+    if (s.is(kLowerTriangular)) {
+        description = "lower-triangular";
+    } else if (s.is(kUpperTriangular)) {
+        description = "upper-triangular";
+    } else if (s.lowerBandwidth + s.upperBandwidth + 1 < cols) {
+        description = "banded(l=" + std::to_string(s.lowerBandwidth) + ",u=" + std::to_string(s.upperBandwidth) + ")";
+    }
+    if (s.is(kSymmetric)) {
+        description += description.empty() ? "symmetric" : ",symmetric";
+    }
+    return description.empty() ? "dense" : description;
+}
+
+const char* multiplyStructured(const Matrix& A, const Matrix& B, Matrix& C,
+                               const MatrixStructure& sa, const MatrixStructure& sb) {
+    if (sa.is(kZero) || sb.is(kZero)) {
+#pragma omp parallel for schedule(static)
+        for (int i = 0; i < C.rows; ++i) {
+            std::fill(C.row(i), C.row(i) + C.span(), 0);
+        }
+        return "zero-fill";
+    }
+    if (sa.is(kIdentity)) {
+        // row i of A is e_(i + offset): row i of C is a row of B
+#pragma omp parallel for schedule(static)
+        for (int i = 0; i < C.rows; ++i) {
+            std::memcpy(C.row(i), B.row(i + sa.rowOffset), static_cast<std::size_t>(C.cols) * sizeof(int));
+            std::fill(C.row(i) + C.cols, C.row(i) + C.span(), 0);
+        }
+        return "identity-copy";
+    }
+    if (sb.is(kIdentity)) {
+        // B holds the first rows of the identity: C is A, zero past the rows of B
+#pragma omp parallel for schedule(static)
+        for (int i = 0; i < C.rows; ++i) {
+            int* c = C.row(i);
+            std::memcpy(c, A.row(i), static_cast<std::size_t>(B.rows) * sizeof(int));
+            std::fill(c + B.rows, c + C.span(), 0);
+        }
+        return "identity-copy";
+    }
+    if (sa.is(kDiagonal)) {
+#pragma omp parallel for schedule(static)
+        for (int i = 0; i < C.rows; ++i) {
+            const int gi = i + sa.rowOffset;
+            const int d = gi < A.cols ? A.at(i, gi) : 0;
+            const int* b = d != 0 ? B.row(gi) : nullptr;
+            int* c = C.row(i);
+            for (int j = 0; j < C.cols; ++j) {
+                c[j] = d != 0 ? d * b[j] : 0;
+            }
+            std::fill(c + C.cols, c + C.span(), 0);
+        }
+        return "diagonal-scale";
+    }
+    if (sb.is(kDiagonal)) {
+#pragma omp parallel for schedule(static)
+        for (int i = 0; i < C.rows; ++i) {
+            const int* a = A.row(i);
+            int* c = C.row(i);
+            std::fill(c, c + C.span(), 0);
+            for (int j = 0; j < std::min(B.rows, B.cols); ++j) {
+                c[j] = a[j] * B.at(j, j);
+            }
+        }
+        return "diagonal-scale";
+    }
+    if (sa.is(kSymmetric) && sb.is(kSymmetric) && A.rows == B.rows && sameContents(A, B)) {
+        multiplySymmetricSquare(A, C);
+        return "symmetric-square";
+    }
+    const double maxWork =
+        quantizedWidth(sa.range, sb.range) == QuantizedWidth::Int32 ? kBandedMaxWork : kBandedMaxWorkQuantized;
+    if (bandedWork(A, B, sa, sb) <= maxWork) {
+        multiplyBanded(A, B, C, sa, sb);
+        return "banded";
+    }
+    return nullptr;
+}
@@ -0,0 +1,106 @@
+#include "vector_kernels.h"
+#include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+
+void dot(const Matrix& A, const Matrix& B, Matrix& C) {
+    const int* a = A.row(0);
+    int sum = 0;
+#pragma omp parallel for reduction(+ : sum) schedule(static)
+    for (int k = 0; k < A.cols; ++k) {
+        sum += a[k] * B.at(k, 0);
+    }
+    std::fill(C.row(0), C.row(0) + C.span(), 0);
+    C.at(0, 0) = sum;
+}
+
+void gemv(const Matrix& A, const Matrix& B, Matrix& C, Arena& workspace) {
+    // B is a padded column: gather it once so that every row is a unit-stride dot product
+    Arena::Scope scratch(workspace);
+    int* b = workspace.allocateArray<int>(B.rows);
+    for (int k = 0; k < B.rows; ++k) {
+        b[k] = B.at(k, 0);
+    }
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < A.rows; ++i) {
+        const int* a = A.row(i);
+        int sum = 0;
+#pragma omp simd reduction(+ : sum)
+        for (int k = 0; k < A.cols; ++k) {
+            sum += a[k] * b[k];
+        }
+        int* c = C.row(i);
+        std::fill(c, c + C.span(), 0);
+        c[0] = sum;
+    }
+}
+
+void gevm(const Matrix& A, const Matrix& B, Matrix& C) {
+    const int* a = A.row(0);
+    int* c = C.row(0);
+#pragma omp parallel
+    {
+        int threads = 1, tid = 0;
+#ifdef _OPENMP
+        threads = omp_get_num_threads();
+        tid = omp_get_thread_num();
+#endif
+        // split on whole cache lines so that two threads never write the same line of C
+        int begin, end;
+        blockRange((C.span() + 15) / 16, threads, tid, begin, end);
+        begin = std::min(begin * 16, C.span());
+        end = std::min(end * 16, C.span());
+        std::fill(c + begin, c + end, 0);
+        end = std::min(end, C.cols);
+        for (int k = 0; k < A.cols; ++k) {
+            const int ak = a[k];
+            const int* b = B.row(k);
+#pragma omp simd
+            for (int j = begin; j < end; ++j) {
+                c[j] += ak * b[j];
+            }
+        }
+    }
+}
+
+void outer(const Matrix& A, const Matrix& B, Matrix& C) {
+    const int* b = B.row(0);
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < A.rows; ++i) {
+        const int ai = A.at(i, 0);
+        int* c = C.row(i);
+#pragma omp simd
+        for (int j = 0; j < C.cols; ++j) {
+            c[j] = ai * b[j];
+        }
+        std::fill(c + C.cols, c + C.span(), 0);
+    }
+}
+
+}
+
+const char* multiplyVectorShape(const Matrix& A, const Matrix& B, Matrix& C, Arena& workspace) {
+    if (A.rows == 0 || B.cols == 0) {
+        return nullptr;
+    }
+    if (A.rows == 1 && B.cols == 1) {
+        dot(A, B, C);
+        return "dot";
+    }
+    if (B.cols == 1) {
+        gemv(A, B, C, workspace);
+        return "gemv";
+    }
+    if (A.rows == 1) {
+        gevm(A, B, C);
+        return "gevm";
+    }
+    if (A.cols == 1) {
+        outer(A, B, C);
+        return "outer";
+    }
+    return nullptr;
+}
@@ -0,0 +1,126 @@
+#include "verify.h"
+#include "random.h"
+#include <algorithm>
+
+namespace {
+
+void randomVector(std::uint64_t seed, int round, int n, std::uint32_t* r) {
+    const std::uint64_t stream = streamSeed(seed, static_cast<std::uint64_t>(round));
+#pragma omp parallel for schedule(static)
+    for (int j = 0; j < n; ++j) {
+        r[j] = static_cast<std::uint32_t>(counterRandom(stream, static_cast<std::uint64_t>(j)));
+    }
+}
+
+/**
+ * out = M v modulo 2^32, threaded over the rows of M.
+ */
+void multiplyVector(const Matrix& M, const std::uint32_t* v, std::uint32_t* out) {
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < M.rows; ++i) {
+        const int* m = M.row(i);
+        std::uint32_t sum = 0;
+#pragma omp simd reduction(+ : sum)
+        for (int k = 0; k < M.cols; ++k) {
+            sum += static_cast<std::uint32_t>(m[k]) * v[k];
+        }
+        out[i] = sum;
+    }
+}
+
+}
+
+bool freivalds(const Matrix& A, const Matrix& B, const Matrix& C, Arena& workspace,
+               int rounds, std::uint64_t seed) {
+    if (A.cols != B.rows || C.rows != A.rows || C.cols != B.cols) {
+        return false;
+    }
+    Arena::Scope scratch(workspace);
+    std::uint32_t* r = workspace.allocateArray<std::uint32_t>(B.cols);
+    std::uint32_t* y = workspace.allocateArray<std::uint32_t>(B.rows);
+    std::uint32_t* x = workspace.allocateArray<std::uint32_t>(A.rows);
+    std::uint32_t* z = workspace.allocateArray<std::uint32_t>(C.rows);
+    for (int round = 0; round < rounds; ++round) {
+        randomVector(seed, round, B.cols, r);
+        multiplyVector(B, r, y);
+        multiplyVector(A, y, x);
+        multiplyVector(C, r, z);
+        if (!std::equal(x, x + A.rows, z)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool distributedFreivalds(const Matrix& A, const Matrix& B, const Matrix& C, MPI_Comm comm,
+                          Arena& storage, Arena& workspace, int rounds, std::uint64_t seed) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    int dims[6] = {A.rows, A.cols, B.rows, B.cols, C.rows, C.cols};
+    MPI_Bcast(dims, 6, MPI_INT, 0, comm);
+    const int rowsA = dims[0], colsA = dims[1], rowsB = dims[2], colsB = dims[3];
+    if (colsA != rowsB || dims[4] != rowsA || dims[5] != colsB) {
+        return false;
+    }
+
+    // rows of A and C in one balanced split, rows of B in another
+    int* counts = storage.allocateArray<int>(size);
+    int* displs = storage.allocateArray<int>(size);
+    int* countsB = storage.allocateArray<int>(size);
+    int* displsB = storage.allocateArray<int>(size);
+    for (int r = 0; r < size; ++r) {
+        int begin, end;
+        blockRange(rowsA, size, r, begin, end);
+        displs[r] = begin;
+        counts[r] = end - begin;
+        blockRange(rowsB, size, r, begin, end);
+        displsB[r] = begin;
+        countsB[r] = end - begin;
+    }
+    const int myRows = counts[rank];
+    const int myRowsB = countsB[rank];
+
+    MPI_Datatype rowA, rowB;
+    MPI_Type_contiguous(paddedStride(colsA), MPI_INT, &rowA);
+    MPI_Type_contiguous(paddedStride(colsB), MPI_INT, &rowB);
+    MPI_Type_commit(&rowA);
+    MPI_Type_commit(&rowB);
+
+    Matrix localA, localB, localC;
+    if (rank == 0) {
+        localA = rowBlock(A, displs[0], myRows);
+        localB = rowBlock(B, displsB[0], myRowsB);
+        localC = rowBlock(C, displs[0], myRows);
+        MPI_Scatterv(A.data, counts, displs, rowA, MPI_IN_PLACE, myRows, rowA, 0, comm);
+        MPI_Scatterv(B.data, countsB, displsB, rowB, MPI_IN_PLACE, myRowsB, rowB, 0, comm);
+        MPI_Scatterv(C.data, counts, displs, rowB, MPI_IN_PLACE, myRows, rowB, 0, comm);
+    } else {
+        localA = allocateMatrix(storage, myRows, colsA);
+        localB = allocateMatrix(storage, myRowsB, colsB);
+        localC = allocateMatrix(storage, myRows, colsB);
+        MPI_Scatterv(nullptr, counts, displs, rowA, localA.data, myRows, rowA, 0, comm);
+        MPI_Scatterv(nullptr, countsB, displsB, rowB, localB.data, myRowsB, rowB, 0, comm);
+        MPI_Scatterv(nullptr, counts, displs, rowB, localC.data, myRows, rowB, 0, comm);
+    }
+    MPI_Type_free(&rowA);
+    MPI_Type_free(&rowB);
+
+    Arena::Scope scratch(workspace);
+    std::uint32_t* r = workspace.allocateArray<std::uint32_t>(colsB);
+    std::uint32_t* y = workspace.allocateArray<std::uint32_t>(rowsB);
+    std::uint32_t* x = workspace.allocateArray<std::uint32_t>(myRows);
+    std::uint32_t* z = workspace.allocateArray<std::uint32_t>(myRows);
+    int agree = 1;
+    for (int round = 0; round < rounds && agree; ++round) {
+        randomVector(seed, round, colsB, r);
+        multiplyVector(localB, r, y + displsB[rank]);
+        MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, y, countsB, displsB, MPI_UINT32_T, comm);
+        multiplyVector(localA, y, x);
+        multiplyVector(localC, r, z);
+        agree = std::equal(x, x + myRows, z) ? 1 : 0;
+        MPI_Allreduce(MPI_IN_PLACE, &agree, 1, MPI_INT, MPI_LAND, comm);
+    }
+    return agree == 1;
+}
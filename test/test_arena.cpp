@@ -0,0 +1,117 @@
+#include "arena.h"
+#include "kernels.h"
+#include "matrix.h"
+#include <cstdint>
+#include <vector>
+#include <gtest/gtest.h>
+
+
+/**************
+ * Arena Test *
+ **************/
+TEST(ArenaTest, BlocksAre64ByteAligned) {
+    Arena arena(4096);
+    for (std::size_t bytes : {1, 3, 64, 100, 1000}) {
+        void* p = arena.allocate(bytes);
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(p) % Arena::kAlignment, 0u);
+    }
+}
+
+
+TEST(ArenaTest, ResetReusesMemoryWithoutSystemAllocations) {
+    // arrange
+    Arena arena(1024);
+
+    // act: the first job spills over several chunks...
+    for (int i = 0; i < 10; ++i) {
+        arena.allocate(512);
+    }
+    const std::size_t firstJob = arena.stats().systemAllocations;
+    arena.reset();
+    const std::size_t afterReset = arena.stats().systemAllocations;
+    // ...the following jobs of the same size must fit in what is already reserved
+    for (int job = 0; job < 5; ++job) {
+        for (int i = 0; i < 10; ++i) {
+            arena.allocate(512);
+        }
+        arena.reset();
+    }
+
+    // assert
+    ASSERT_GT(firstJob, 1u);
+    ASSERT_EQ(afterReset, firstJob + 1) << "reset must merge the chunks into a single one";
+    ASSERT_EQ(arena.stats().systemAllocations, afterReset);
+    ASSERT_EQ(arena.stats().resets, 6u);
+}
+
+
+TEST(ArenaTest, ScopeGivesBackScratchMemory) {
+    Arena arena(4096);
+    arena.allocate(100);
+    const std::size_t before = arena.bytesInUse();
+    {
+        Arena::Scope scratch(arena);
+        arena.allocate(2000);
+        arena.allocate(10000);
+    }
+    ASSERT_EQ(arena.bytesInUse(), before);
+}
+
+
+TEST(ArenaTest, HugePagesFallBackGracefully) {
+    Arena arena(1024, true);
+    int* p = arena.allocateArray<int>(1000);
+    p[999] = 42;
+    ASSERT_EQ(p[999], 42);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(p) % Arena::kAlignment, 0u);
+}
+
+
+/***********************
+ * Blocked Kernel Test *
+ ***********************/
+TEST(BlockedKernelTest, MatchesNaiveProductAndDoesNotAllocateWhenWarm) {
+    // arrange: small blocks so that every edge case of the tiling is hit
+    const int rowsA = 37, colsA = 29, colsB = 41;
+    Arena storage, workspace;
+    Matrix A = allocateMatrix(storage, rowsA, colsA);
+    Matrix B = allocateMatrix(storage, colsA, colsB);
+    Matrix C = allocateMatrix(storage, rowsA, colsB);
+    for (int i = 0; i < rowsA; ++i)
+        for (int k = 0; k < colsA; ++k)
+            A.at(i, k) = (i * 7 + k * 3) % 11 - 5;
+    for (int k = 0; k < colsA; ++k)
+        for (int j = 0; j < colsB; ++j)
+            B.at(k, j) = (k * 5 + j) % 13 - 6;
+    BlockSizes blocks;
+    blocks.mc = 8;
+    blocks.kc = 7;
+    blocks.nc = 16;
+
+    // act
+    multiplyBlocked(A, B, C, workspace, blocks);
+    const std::size_t warm = workspace.stats().systemAllocations;
+    multiplyBlocked(A, B, C, workspace, blocks);
+
+    // assert
+    for (int i = 0; i < rowsA; ++i) {
+        for (int j = 0; j < colsB; ++j) {
+            int expected = 0;
+            for (int k = 0; k < colsA; ++k) {
+                expected += A.at(i, k) * B.at(k, j);
+            }
+            ASSERT_EQ(C.at(i, j), expected) << "at (" << i << ", " << j << ")";
+        }
+    }
+    ASSERT_EQ(workspace.stats().systemAllocations, warm);
+    ASSERT_EQ(workspace.bytesInUse(), 0u);
+}
+
+
+TEST(BlockedKernelTest, NestedConversionRoundTrip) {
+    Arena arena;
+    std::vector<std::vector<int>> nested = {{1, 2, 3}, {4, 5, 6}};
+    Matrix M = fromNested(arena, nested);
+    ASSERT_EQ(M.stride % 16, 0);
+    ASSERT_EQ(toNested(M), nested);
+}
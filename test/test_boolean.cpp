@@ -0,0 +1,93 @@
+#include "boolean.h"
+#include "kernels.h"
+#include "random.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+
+namespace {
+
+Matrix randomBits(Arena& arena, int rows, int cols, std::uint64_t seed, int percent) {
+    Matrix M = allocateMatrix(arena, rows, cols);
+    fillMatrix(M, 0);
+    for (int i = 0; i < rows; ++i)
+        for (int j = 0; j < cols; ++j)
+            M.at(i, j) = counterRandom(seed, static_cast<std::uint64_t>(i) * cols + j) % 100 < static_cast<unsigned>(percent);
+    return M;
+}
+
+}
+
+
+/*************************
+ * Boolean Multiply Test *
+ ************************/
+TEST(BooleanMultiplyTest, MatchesTheNonZerosOfTheIntegerProduct) {
+    // arrange
+    Arena storage, workspace;
+    Matrix A = randomBits(storage, 130, 300, 1, 2);
+    Matrix B = randomBits(storage, 300, 75, 2, 2);
+    Matrix expected = allocateMatrix(storage, 130, 75);
+    multiplyNaive(A, B, expected);
+    BitMatrix C = allocateBitMatrix(storage, 130, 75);
+
+    // act
+    multiplyBoolean(packBits(A, storage), packBits(B, storage), C, workspace);
+
+    // assert
+    for (int i = 0; i < 130; ++i)
+        for (int j = 0; j < 75; ++j)
+            ASSERT_EQ(C.get(i, j), expected.at(i, j) != 0) << i << "," << j;
+}
+
+
+TEST(BooleanMultiplyTest, CountsWitnessesWithPopcount) {
+    Arena storage, workspace;
+    Matrix A = randomBits(storage, 70, 520, 3, 50);
+    Matrix B = randomBits(storage, 520, 90, 4, 50);
+    Matrix expected = allocateMatrix(storage, 70, 90);
+    multiplyNaive(A, B, expected);
+    Matrix C = allocateMatrix(storage, 70, 90);
+    countBoolean(packBits(A, storage), packBits(B, storage), C, workspace);
+    ASSERT_EQ(toNested(C), toNested(expected));
+}
+
+
+TEST(BooleanMultiplyTest, TransposesAndUnpacks) {
+    Arena storage;
+    Matrix M = randomBits(storage, 65, 129, 5, 30);
+    BitMatrix T = transposeBits(packBits(M, storage), storage);
+    Matrix back = allocateMatrix(storage, 129, 65);
+    unpackBits(T, back);
+    for (int i = 0; i < 65; ++i)
+        for (int j = 0; j < 129; ++j)
+            ASSERT_EQ(back.at(j, i), M.at(i, j));
+    ASSERT_EQ(T.words % 8, 0);
+    ASSERT_EQ(T.row(0)[1] >> 1, 0u);  // padding bits past column 65 stay clear
+}
+
+
+TEST(BooleanMultiplyTest, ReadsOnlyZeroOneText) {
+    const char* path = "test_boolean_matrix.txt";
+    Arena storage;
+    BitMatrix M;
+    {
+        std::ofstream out(path);
+        out << "2 3\n1 0 1\n0 1 1\n";
+    }
+    ASSERT_TRUE(readBitMatrixFromFile(path, storage, M));
+    ASSERT_EQ(M.rows, 2);
+    ASSERT_EQ(M.row(0)[0], 0b101u);
+    ASSERT_EQ(M.row(1)[0], 0b110u);
+    {
+        std::ofstream out(path);
+        out << "1 3\n1 2 1\n";
+    }
+    ASSERT_FALSE(readBitMatrixFromFile(path, storage, M));
+    {
+        std::ofstream out(path);
+        out << "1 3\n1 10 1\n";
+    }
+    ASSERT_FALSE(readBitMatrixFromFile(path, storage, M));
+    std::remove(path);
+}
@@ -0,0 +1,63 @@
+#include "bounded_queue.h"
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+
+/**********************
+ * Bounded Queue Test *
+ **********************/
+TEST(BoundedQueueTest, KeepsFifoOrderAcrossThreads) {
+    // arrange: a tiny capacity so that the producer has to wait for the consumer
+    BoundedQueue<int> queue(2);
+    std::vector<int> received;
+
+    // act
+    std::thread producer([&] {
+        for (int i = 0; i < 1000; ++i) {
+            queue.push(i);
+        }
+        queue.close();
+    });
+    int value;
+    while (queue.pop(value)) {
+        received.push_back(value);
+    }
+    producer.join();
+
+    // assert
+    ASSERT_EQ(received.size(), 1000u);
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_EQ(received[i], i);
+    }
+}
+
+
+TEST(BoundedQueueTest, CloseDrainsThenStops) {
+    BoundedQueue<int> queue(4);
+    queue.push(1);
+    queue.push(2);
+    queue.close();
+    int value;
+    ASSERT_FALSE(queue.push(3));
+    ASSERT_TRUE(queue.pop(value));
+    ASSERT_EQ(value, 1);
+    ASSERT_TRUE(queue.pop(value));
+    ASSERT_EQ(value, 2);
+    ASSERT_FALSE(queue.pop(value));
+}
+
+
+TEST(BoundedQueueTest, PopForTimesOutUntilDrained) {
+    BoundedQueue<int> queue(4);
+    int value;
+    ASSERT_FALSE(queue.popFor(value, std::chrono::milliseconds(1)));
+    ASSERT_FALSE(queue.drained());
+    queue.push(5);
+    queue.close();
+    ASSERT_FALSE(queue.drained());
+    ASSERT_TRUE(queue.popFor(value, std::chrono::milliseconds(1)));
+    ASSERT_EQ(value, 5);
+    ASSERT_FALSE(queue.popFor(value, std::chrono::milliseconds(1)));
+    ASSERT_TRUE(queue.drained());
+}
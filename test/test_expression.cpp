@@ -0,0 +1,159 @@
+#include "expression.h"
+#include "test_matrices.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+Matrix product(Arena& arena, const Matrix& A, const Matrix& B) {
+    Matrix C = allocateMatrix(arena, A.rows, B.cols);
+    multiplyNaive(A, B, C);
+    return C;
+}
+
+Matrix transposedCopy(Arena& arena, const Matrix& M) {
+    Matrix T = allocateMatrix(arena, M.cols, M.rows);
+    fillMatrix(T, 0);
+    for (int i = 0; i < M.rows; ++i)
+        for (int j = 0; j < M.cols; ++j)
+            T.at(j, i) = M.at(i, j);
+    return T;
+}
+
+BlockSizes smallBlocks() {
+    BlockSizes blocks;
+    blocks.mc = 8;
+    blocks.kc = 16;
+    blocks.nc = 16;
+    blocks.mr = 4;
+    return blocks;
+}
+
+}
+
+
+/*******************
+ * Expression Test *
+ *******************/
+TEST(ExpressionTest, ProductPlusMatrix) {
+    // arrange
+    Arena storage, workspace;
+    Matrix A = randomMatrix(storage, 30, 40, 1, -100, 100);
+    Matrix B = randomMatrix(storage, 40, 25, 2, -100, 100);
+    Matrix C = randomMatrix(storage, 30, 25, 3, -100, 100);
+    Matrix AB = product(storage, A, B);
+    Matrix R = allocateMatrix(storage, 30, 25);
+
+    // act
+    evaluate(A * B + C, R, workspace, smallBlocks());
+
+    // assert
+    for (int i = 0; i < 30; ++i)
+        for (int j = 0; j < 25; ++j)
+            ASSERT_EQ(R.at(i, j), AB.at(i, j) + C.at(i, j));
+}
+
+TEST(ExpressionTest, SumOfProductsAccumulatesInPlace) {
+    // arrange
+    Arena storage, workspace;
+    Matrix A = randomMatrix(storage, 30, 40, 4, -100, 100);
+    Matrix B = randomMatrix(storage, 40, 25, 5, -100, 100);
+    Matrix C = randomMatrix(storage, 30, 19, 6, -100, 100);
+    Matrix D = randomMatrix(storage, 19, 25, 7, -100, 100);
+    Matrix AB = product(storage, A, B);
+    Matrix CD = product(storage, C, D);
+    Matrix R = randomMatrix(storage, 30, 25, 8, -100, 100);
+    Matrix R0 = randomMatrix(storage, 30, 25, 8, -100, 100);
+
+    // act
+    evaluate(A * B + 3 * (C * D) + R, R, workspace, smallBlocks());
+
+    // assert
+    for (int i = 0; i < 30; ++i)
+        for (int j = 0; j < 25; ++j)
+            ASSERT_EQ(R.at(i, j), AB.at(i, j) + 3 * CD.at(i, j) + R0.at(i, j));
+}
+
+TEST(ExpressionTest, FusesHadamardAndRelu) {
+    // arrange
+    Arena storage, workspace;
+    Matrix A = randomMatrix(storage, 33, 20, 9, -100, 100);
+    Matrix B = randomMatrix(storage, 20, 41, 10, -100, 100);
+    Matrix C = randomMatrix(storage, 33, 50, 11, -100, 100);
+    Matrix D = randomMatrix(storage, 50, 41, 12, -100, 100);
+    Matrix M = randomMatrix(storage, 33, 41, 13, -100, 100);
+    Matrix E = randomMatrix(storage, 33, 41, 14, -100, 100);
+    Matrix AB = product(storage, A, B);
+    Matrix CD = product(storage, C, D);
+    Matrix relu1 = allocateMatrix(storage, 33, 41);
+    Matrix relu2 = allocateMatrix(storage, 33, 41);
+    Matrix masked = allocateMatrix(storage, 33, 41);
+
+    // act
+    evaluate(relu(A * B), relu1, workspace, smallBlocks());
+    evaluate(hadamard(M, A * B), masked, workspace, smallBlocks());
+    evaluate(relu(hadamard(A * B + C * D, M) + E), relu2, workspace, smallBlocks());
+
+    // assert
+    for (int i = 0; i < 33; ++i)
+        for (int j = 0; j < 41; ++j) {
+            ASSERT_EQ(relu1.at(i, j), std::max(AB.at(i, j), 0));
+            ASSERT_EQ(masked.at(i, j), M.at(i, j) * AB.at(i, j));
+            ASSERT_EQ(relu2.at(i, j), std::max((AB.at(i, j) + CD.at(i, j)) * M.at(i, j) + E.at(i, j), 0));
+        }
+}
+
+TEST(ExpressionTest, TransposedOperands) {
+    // arrange
+    Arena storage, workspace;
+    Matrix A = randomMatrix(storage, 30, 40, 15, -100, 100);
+    Matrix B = randomMatrix(storage, 40, 25, 16, -100, 100);
+    Matrix At = transposedCopy(storage, A);
+    Matrix Bt = transposedCopy(storage, B);
+    Matrix AB = product(storage, A, B);
+    Matrix R = allocateMatrix(storage, 30, 25);
+
+    // act
+    evaluate(relu(transposed(At) * B + -2 * (A * transposed(Bt))), R, workspace, smallBlocks());
+
+    // assert
+    for (int i = 0; i < 30; ++i)
+        for (int j = 0; j < 25; ++j)
+            ASSERT_EQ(R.at(i, j), std::max(-AB.at(i, j), 0));
+}
+
+TEST(ExpressionTest, ElementwiseWithoutProducts) {
+    // arrange
+    Arena storage, workspace;
+    Matrix M = randomMatrix(storage, 17, 23, 17, -100, 100);
+    Matrix N = randomMatrix(storage, 17, 23, 18, -100, 100);
+    Matrix R = randomMatrix(storage, 17, 23, 19, -100, 100);
+
+    // act
+    evaluate(relu(hadamard(M, N) + M), R, workspace, smallBlocks());
+
+    // assert
+    for (int i = 0; i < 17; ++i)
+        for (int j = 0; j < 23; ++j)
+            ASSERT_EQ(R.at(i, j), std::max(M.at(i, j) * N.at(i, j) + M.at(i, j), 0));
+}
+
+TEST(ExpressionTest, WritesIntoAView) {
+    // arrange
+    Arena storage, workspace;
+    Matrix A = randomMatrix(storage, 20, 30, 20, -100, 100);
+    Matrix B = randomMatrix(storage, 30, 10, 21, -100, 100);
+    Matrix AB = product(storage, A, B);
+    Matrix parent = allocateMatrix(storage, 24, 40);
+    fillMatrix(parent, -7);
+    Matrix R = subMatrix(parent, 2, 5, 20, 10);
+
+    // act
+    evaluate(relu(A * B), R, workspace, smallBlocks());
+
+    // assert
+    for (int i = 0; i < parent.rows; ++i)
+        for (int j = 0; j < parent.stride; ++j) {
+            const bool inside = i >= 2 && i < 22 && j >= 5 && j < 15;
+            ASSERT_EQ(parent.row(i)[j], inside ? std::max(AB.at(i - 2, j - 5), 0) : -7);
+        }
+}
@@ -0,0 +1,92 @@
+#include "kernels.h"
+#include "test_matrices.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+Matrix transposed(Arena& arena, const Matrix& M) {
+    Matrix T = allocateMatrix(arena, M.cols, M.rows);
+    fillMatrix(T, 0);
+    for (int i = 0; i < M.rows; ++i)
+        for (int j = 0; j < M.cols; ++j)
+            T.at(j, i) = M.at(i, j);
+    return T;
+}
+
+}
+
+
+/*************
+ * Gemm Test *
+ *************/
+TEST(GemmTest, MatchesAlphaTimesTheProductPlusBetaTimesC) {
+    // arrange
+    Arena storage, workspace;
+    Matrix A = randomMatrix(storage, 45, 70, 1, -1000, 1000);
+    Matrix B = randomMatrix(storage, 70, 33, 2, -1000, 1000);
+    Matrix C0 = randomMatrix(storage, 45, 33, 3, -1000, 1000);
+    Matrix AB = allocateMatrix(storage, 45, 33);
+    multiplyNaive(A, B, AB);
+    BlockSizes blocks;
+    blocks.mc = 16;
+    blocks.kc = 32;
+    blocks.nc = 20;
+    blocks.mr = 4;
+
+    for (Transpose ta : {Transpose::No, Transpose::Yes}) {
+        for (Transpose tb : {Transpose::No, Transpose::Yes}) {
+            for (int alpha : {0, 1, -3}) {
+                for (int beta : {0, 1, 2}) {
+                    Matrix C = allocateMatrix(storage, 45, 33);
+                    std::copy(C0.data, C0.data + C0.storageSize(), C.data);
+
+                    // act
+                    gemm(ta, tb, alpha, ta == Transpose::Yes ? transposed(storage, A) : A,
+                         tb == Transpose::Yes ? transposed(storage, B) : B, beta, C, workspace, blocks);
+
+                    // assert
+                    for (int i = 0; i < 45; ++i)
+                        for (int j = 0; j < 33; ++j)
+                            ASSERT_EQ(C.at(i, j), alpha * AB.at(i, j) + beta * C0.at(i, j))
+                                << "ta=" << (ta == Transpose::Yes) << " tb=" << (tb == Transpose::Yes)
+                                << " alpha=" << alpha << " beta=" << beta;
+                }
+            }
+        }
+    }
+}
+
+
+TEST(GemmTest, BetaZeroIgnoresWhatCHolds) {
+    Arena storage, workspace;
+    Matrix A = fromNested(storage, {{1, 2}, {3, 4}});
+    Matrix C = allocateMatrix(storage, 2, 2);
+    fillMatrix(C, 0x7fffffff);
+    gemm(Transpose::No, Transpose::Yes, 1, A, A, 0, C, workspace);
+    ASSERT_EQ(toNested(C), (std::vector<std::vector<int>>{{5, 11}, {11, 25}}));
+    ASSERT_EQ(C.row(0)[2], 0);  // padding zeroed like multiplyBlocked does
+}
+
+
+TEST(GemmTest, AccumulatesPartialProductsIntoAViewOfC) {
+    Arena storage, workspace;
+    Matrix A = randomMatrix(storage, 20, 60, 4, -1000, 1000);
+    Matrix B = randomMatrix(storage, 60, 25, 5, -1000, 1000);
+    Matrix expected = allocateMatrix(storage, 20, 25);
+    multiplyNaive(A, B, expected);
+
+    // C = sum over two K panels, the second accumulated with beta = 1, on rows 5.. of C
+    Matrix C = allocateMatrix(storage, 25, 25);
+    Matrix lower = rowBlock(C, 5, 20);
+    Matrix A1 = A, A2 = A;
+    A1.cols = 30;
+    A2.cols = 30;
+    A2.data += 30;
+    Matrix B1 = rowBlock(B, 0, 30), B2 = rowBlock(B, 30, 30);
+    gemm(Transpose::No, Transpose::No, 1, A1, B1, 0, lower, workspace);
+    gemm(Transpose::No, Transpose::No, 1, A2, B2, 1, lower, workspace);
+
+    for (int i = 0; i < 20; ++i)
+        for (int j = 0; j < 25; ++j)
+            ASSERT_EQ(C.at(5 + i, j), expected.at(i, j));
+}
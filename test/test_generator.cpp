@@ -0,0 +1,127 @@
+#include "generator.h"
+#include "structure.h"
+#include <unistd.h>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <gtest/gtest.h>
+
+namespace {
+
+Matrix generate(Arena& arena, const GeneratorSpec& spec) {
+    Matrix M = allocateMatrix(arena, spec.rows, spec.cols);
+    generateRows(spec, 0, M);
+    return M;
+}
+
+std::string describe(Arena& arena, MatrixKind kind, int n) {
+    GeneratorSpec spec;
+    spec.kind = kind;
+    spec.rows = n;
+    spec.cols = n;
+    spec.minValue = 1;
+    spec.maxValue = 9;
+    return describeStructure(detectStructure(generate(arena, spec)), n);
+}
+
+}
+
+
+/******************
+ * Generator Test *
+ ******************/
+TEST(GeneratorTest, KindsHaveTheirStructure) {
+    Arena arena;
+    ASSERT_EQ(describe(arena, MatrixKind::Random, 40), "dense");
+    ASSERT_EQ(describe(arena, MatrixKind::Identity, 40), "identity");
+    ASSERT_EQ(describe(arena, MatrixKind::Diagonal, 40), "diagonal");
+    ASSERT_EQ(describe(arena, MatrixKind::Banded, 40), "banded(l=1,u=1)");
+    ASSERT_EQ(describe(arena, MatrixKind::LowerTriangular, 40), "lower-triangular");
+    ASSERT_EQ(describe(arena, MatrixKind::UpperTriangular, 40), "upper-triangular");
+    ASSERT_EQ(describe(arena, MatrixKind::Symmetric, 40), "symmetric");
+}
+
+
+TEST(GeneratorTest, RowBlocksMatchTheWholeMatrix) {
+    // arrange
+    Arena arena;
+    GeneratorSpec spec;
+    spec.rows = 50;
+    spec.cols = 37;
+    spec.seed = 42;
+    Matrix whole = generate(arena, spec);
+    Matrix block = allocateMatrix(arena, 11, spec.cols);
+
+    // act
+    generateRows(spec, 20, block);
+
+    // assert
+    for (int i = 0; i < block.rows; ++i)
+        for (int j = 0; j < block.cols; ++j)
+            ASSERT_EQ(block.at(i, j), whole.at(20 + i, j));
+}
+
+
+TEST(GeneratorTest, ValuesStayInRangeAndDependOnTheSeed) {
+    Arena arena;
+    GeneratorSpec spec;
+    spec.rows = 30;
+    spec.cols = 30;
+    spec.minValue = -3;
+    spec.maxValue = 4;
+    Matrix first = generate(arena, spec);
+    spec.seed = 2;
+    Matrix second = generate(arena, spec);
+    bool differ = false;
+    for (int i = 0; i < spec.rows; ++i) {
+        for (int j = 0; j < spec.cols; ++j) {
+            ASSERT_GE(first.at(i, j), -3);
+            ASSERT_LE(first.at(i, j), 4);
+            differ = differ || first.at(i, j) != second.at(i, j);
+        }
+    }
+    ASSERT_TRUE(differ);
+}
+
+
+TEST(GeneratorTest, SparseDensity) {
+    Arena arena;
+    GeneratorSpec spec;
+    spec.kind = MatrixKind::Sparse;
+    spec.rows = 200;
+    spec.cols = 200;
+    spec.minValue = 1;
+    spec.density = 0.05;
+    Matrix M = generate(arena, spec);
+    int nonzeros = 0;
+    for (int i = 0; i < spec.rows; ++i)
+        for (int j = 0; j < spec.cols; ++j)
+            nonzeros += M.at(i, j) != 0;
+    ASSERT_GT(nonzeros, 1600);
+    ASSERT_LT(nonzeros, 2400);
+}
+
+
+TEST(GeneratorTest, BinaryLayoutRoundTrip) {
+    // arrange
+    Arena arena;
+    GeneratorSpec spec;
+    spec.rows = 9;
+    spec.cols = 21;
+    Matrix M = generate(arena, spec);
+    char path[] = "/tmp/generator_test_XXXXXX";
+    close(mkstemp(path));
+    {
+        std::ofstream out(path, std::ios::binary);
+        writeMatrixBinary(out, M);
+    }
+
+    // act
+    Matrix read;
+    const bool ok = readMatrixFromFile(path, arena, read);
+    unlink(path);
+
+    // assert
+    ASSERT_TRUE(ok);
+    ASSERT_EQ(toNested(read), toNested(M));
+}
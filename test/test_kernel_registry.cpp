@@ -0,0 +1,143 @@
+#include "kernel_registry.h"
+#include "kernels.h"
+#include "test_matrices.h"
+#include <unistd.h>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <gtest/gtest.h>
+
+namespace {
+
+std::string temporaryPath() {
+    char path[] = "/tmp/kernel_registry_test_XXXXXX";
+    close(mkstemp(path));
+    return path;
+}
+
+}
+
+
+/************************
+ * Kernel Variants Test *
+ ************************/
+TEST(KernelVariantsTest, EveryVariantGivesTheExactProduct) {
+    // arrange
+    Arena storage, workspace;
+    Matrix A = randomMatrix(storage, 67, 45, 1, -120, 120);
+    Matrix B = randomMatrix(storage, 45, 53, 2, -120, 120);
+    Matrix expected = allocateMatrix(storage, 67, 53);
+    multiplyNaive(A, B, expected);
+    KernelRegistry registry;
+
+    for (const KernelVariant& variant : registry.variants()) {
+        Matrix C = allocateMatrix(storage, 67, 53);
+        fillMatrix(C, -1);
+
+        // act
+        variant.run(A, B, C, workspace);
+
+        // assert
+        ASSERT_EQ(toNested(C), toNested(expected)) << variant.name;
+    }
+}
+
+
+TEST(KernelVariantsTest, StrassenRecursesOnOddShapes) {
+    Arena storage, workspace;
+    Matrix A = randomMatrix(storage, 101, 77, 3, -120, 120);
+    Matrix B = randomMatrix(storage, 77, 90, 4, -120, 120);
+    Matrix expected = allocateMatrix(storage, 101, 90);
+    Matrix C = allocateMatrix(storage, 101, 90);
+    multiplyNaive(A, B, expected);
+    multiplyStrassen(A, B, C, workspace, 8);
+    ASSERT_EQ(toNested(C), toNested(expected));
+}
+
+
+/************************
+ * Kernel Registry Test *
+ ************************/
+TEST(KernelRegistryTest, ShapeClassesUseLog2Buckets) {
+    ASSERT_EQ(KernelRegistry::shapeClass(1000, 1024, 1025, QuantizedWidth::Int32), "int32 m10 k10 n11");
+    ASSERT_EQ(KernelRegistry::shapeClass(1, 2, 3, QuantizedWidth::Int8), "int8 m0 k1 n2");
+}
+
+
+TEST(KernelRegistryTest, TunedWinnersArePersistedPerCpuModel) {
+    // arrange
+    const std::string path = temporaryPath();
+    {
+        std::ofstream other(path);
+        other << "Some Other CPU\tint32 m6 k6 n6\tnaive\n";
+    }
+    Arena workspace;
+    KernelRegistry tuner;
+    tuner.load(path);
+    tuner.setTuneOnMiss(false);
+    ASSERT_EQ(tuner.select(40, 40, 40, QuantizedWidth::Int32, workspace), nullptr);
+
+    // act
+    const std::string winner = tuner.tune(40, 40, 40, QuantizedWidth::Int32, workspace).name;
+    ASSERT_TRUE(tuner.save(path));
+    KernelRegistry later;
+    later.setTuneOnMiss(false);
+    const bool loaded = later.load(path);
+
+    // assert
+    ASSERT_TRUE(loaded);
+    const KernelVariant* selected = later.select(33, 60, 50, QuantizedWidth::Int32, workspace);
+    ASSERT_NE(selected, nullptr);
+    ASSERT_EQ(selected->name, winner);
+    std::ifstream saved(path);
+    const std::string contents((std::istreambuf_iterator<char>(saved)), std::istreambuf_iterator<char>());
+    ASSERT_NE(contents.find("Some Other CPU\tint32 m6 k6 n6\tnaive"), std::string::npos);
+    unlink(path.c_str());
+}
+
+
+TEST(KernelRegistryTest, UntunedClassesUseTheNearestClassOfTheirWidth) {
+    // arrange
+    const std::string path = temporaryPath();
+    KernelRegistry registry;
+    {
+        std::ofstream table(path);
+        table << registry.cpuModel() << "\tint32 m6 k6 n6\tnaive\n";
+        table << registry.cpuModel() << "\tint32 m9 k9 n9\tstrassen threshold=128\n";
+    }
+    registry.load(path);
+    registry.setTuneOnMiss(false);
+    Arena workspace;
+
+    // act
+    const KernelVariant* large = registry.select(3000, 2000, 2500, QuantizedWidth::Int32, workspace);
+    const KernelVariant* small = registry.select(50, 70, 60, QuantizedWidth::Int32, workspace);
+    const KernelVariant* exact = registry.select(64, 64, 64, QuantizedWidth::Int32, workspace);
+    const KernelVariant* int8 = registry.select(64, 64, 64, QuantizedWidth::Int8, workspace);
+
+    // assert
+    ASSERT_NE(large, nullptr);
+    ASSERT_EQ(large->name, "strassen threshold=128");
+    ASSERT_NE(small, nullptr);
+    ASSERT_EQ(small->name, "naive");
+    ASSERT_NE(exact, nullptr);
+    ASSERT_EQ(int8, nullptr);
+    ASSERT_EQ(registry.lookups().exact, 1);
+    ASSERT_EQ(registry.lookups().nearest, 2);
+    ASSERT_EQ(registry.lookups().misses, 1);
+    unlink(path.c_str());
+}
+
+
+TEST(KernelRegistryTest, MultiplyAutoDispatchesToTheTunedVariant) {
+    Arena storage, workspace;
+    Matrix A = randomMatrix(storage, 30, 30, 5, -120, 120);
+    Matrix B = randomMatrix(storage, 30, 30, 6, -120, 120);
+    Matrix C = allocateMatrix(storage, 30, 30);
+    KernelRegistry registry;
+    KernelReport report;
+    multiplyAuto(A, B, C, workspace, &report, 0, &registry);
+    ASSERT_TRUE(registry.changed());
+    ASSERT_NE(registry.find(report.kernel), nullptr);
+}
@@ -0,0 +1,25 @@
+#ifndef TEST_MATRICES_H
+#define TEST_MATRICES_H
+
+#include "arena.h"
+#include "matrix.h"
+#include "random.h"
+#include <cstdint>
+
+/**
+ * rows x cols matrix of values drawn uniformly from [lo, hi] with counterRandom(seed, i * cols + j),
+ * so the same seed always gives the same matrix. The padding is zeroed.
+ */
+inline Matrix randomMatrix(Arena& arena, int rows, int cols, std::uint64_t seed, int lo, int hi) {
+    const std::uint64_t values = static_cast<std::uint64_t>(static_cast<std::int64_t>(hi) - lo) + 1;
+    Matrix M = allocateMatrix(arena, rows, cols);
+    fillMatrix(M, 0);
+    for (int i = 0; i < rows; ++i)
+        for (int j = 0; j < cols; ++j) {
+            const std::uint64_t r = counterRandom(seed, static_cast<std::uint64_t>(i) * cols + j);
+            M.at(i, j) = static_cast<int>(lo + static_cast<std::int64_t>(r % values));
+        }
+    return M;
+}
+
+#endif // TEST_MATRICES_H
@@ -0,0 +1,81 @@
+#include "modular.h"
+#include "test_matrices.h"
+#include <climits>
+#include <gtest/gtest.h>
+
+namespace {
+
+/**
+ * Reference A * B mod p, every term reduced on its own.
+ */
+bool matchesReference(const Matrix& A, const Matrix& B, const Matrix& C, std::int64_t p) {
+    for (int i = 0; i < A.rows; ++i) {
+        for (int j = 0; j < B.cols; ++j) {
+            std::uint64_t sum = 0;
+            for (int k = 0; k < A.cols; ++k) {
+                const std::uint64_t a = static_cast<std::uint64_t>((A.at(i, k) % p + p) % p);
+                const std::uint64_t b = static_cast<std::uint64_t>((B.at(k, j) % p + p) % p);
+                sum = (sum + a * b % p) % p;
+            }
+            if (static_cast<std::uint64_t>(C.at(i, j)) != sum) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+}
+
+
+/*************************
+ * Modular Multiply Test *
+ ************************/
+TEST(ModularMultiplyTest, MatchesTheReferenceForSmallAndLargePrimes) {
+    // arrange
+    Arena storage, workspace;
+    Matrix A = randomMatrix(storage, 37, 300, 1, INT_MIN, INT_MAX);
+    Matrix B = randomMatrix(storage, 300, 45, 2, INT_MIN, INT_MAX);
+    Matrix C = allocateMatrix(storage, 37, 45);
+
+    for (std::uint32_t p : {2u, 65521u, 1000000007u, 2147483647u}) {
+        // act
+        multiplyModular(A, B, C, Modulus(p), workspace);
+
+        // assert
+        ASSERT_TRUE(matchesReference(A, B, C, p)) << "p=" << p;
+    }
+}
+
+
+TEST(ModularMultiplyTest, DelaysReductionOverALongInnerDimension) {
+    Arena storage, workspace;
+    Matrix A = randomMatrix(storage, 5, 3000, 3, INT_MIN, INT_MAX);
+    Matrix B = randomMatrix(storage, 3000, 7, 4, INT_MIN, INT_MAX);
+    Matrix C = allocateMatrix(storage, 5, 7);
+    BlockSizes blocks;
+    blocks.kc = 1000;
+    blocks.nc = 4;
+    multiplyModular(A, B, C, Modulus(2147483647u), workspace, blocks);
+    ASSERT_TRUE(matchesReference(A, B, C, 2147483647));
+}
+
+
+TEST(ModularMultiplyTest, ReducesNegativeOperands) {
+    Arena storage, workspace;
+    Matrix A = fromNested(storage, {{-1, 2}, {3, -4}});
+    Matrix B = fromNested(storage, {{5, -6}, {-7, 8}});
+    Matrix C = allocateMatrix(storage, 2, 2);
+    multiplyModular(A, B, C, Modulus(7), workspace);
+    // A * B = {{-19, 22}, {43, -50}}
+    ASSERT_EQ(toNested(C), (std::vector<std::vector<int>>{{2, 1}, {1, 6}}));
+}
+
+
+TEST(ModularMultiplyTest, ComputesTheDelayFromTheModulus) {
+    ASSERT_EQ(Modulus(2).delay, 1 << 30);
+    ASSERT_GE(Modulus(2147483647u).delay, 4);
+    ASSERT_FALSE(Modulus::valid(1));
+    ASSERT_FALSE(Modulus::valid(std::uint64_t(1) << 31));
+    ASSERT_TRUE(Modulus::valid(2147483647u));
+}
@@ -0,0 +1,44 @@
+#include "perf_counters.h"
+#include <sstream>
+#include <gtest/gtest.h>
+
+
+/**********************
+ * Perf Counters Test *
+ **********************/
+TEST(PerfCountersTest, CountsOrExplainsWhyNot) {
+    // arrange
+    PerfCounters counters;
+    const CounterValues before = counters.read();
+    volatile long sum = 0;
+    for (int i = 0; i < 1000000; ++i) {
+        sum += i;
+    }
+
+    // act
+    counters.add("loop", counters.read() - before, 1e6, 0.001);
+    std::ostringstream report;
+    counters.report(report, 0);
+
+    // assert
+    if (counters.available()) {
+        ASSERT_NE(report.str().find("counters loop: calls=1"), std::string::npos);
+    } else {
+        ASSERT_FALSE(counters.error().empty());
+        ASSERT_NE(report.str().find("unavailable"), std::string::npos);
+        ASSERT_FALSE(before.valid[kCycles]);
+    }
+}
+
+
+TEST(PerfCountersTest, DifferencesOfInvalidValuesStayInvalid) {
+    CounterValues later, earlier;
+    later.count[kCycles] = 10;
+    later.valid[kCycles] = true;
+    earlier.count[kCycles] = 4;
+    earlier.valid[kCycles] = true;
+    const CounterValues delta = later - earlier;
+    ASSERT_TRUE(delta.valid[kCycles]);
+    ASSERT_EQ(delta.count[kCycles], 6u);
+    ASSERT_FALSE(delta.valid[kInstructions]);
+}
@@ -0,0 +1,117 @@
+#include "kernels.h"
+#include "matrix.h"
+#include "placement.h"
+#include "progress.h"
+#include <sched.h>
+#include <gtest/gtest.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+/******************
+ * Partition Test *
+ ******************/
+TEST(PartitionTest, BlockRangeCoversEveryRowOnce) {
+    for (int parts = 1; parts <= 7; ++parts) {
+        int expectedBegin = 0;
+        for (int part = 0; part < parts; ++part) {
+            int begin, end;
+            blockRange(20, parts, part, begin, end);
+            ASSERT_EQ(begin, expectedBegin);
+            ASSERT_LE(end - begin, 20 / parts + 1);
+            ASSERT_GE(end - begin, 20 / parts);
+            expectedBegin = end;
+        }
+        ASSERT_EQ(expectedBegin, 20);
+    }
+}
+
+
+TEST(PartitionTest, GuidedRangesShrinkAndCoverEveryRowOnce) {
+    const std::vector<int> bounds = guidedRanges(101, 3, 4);
+    ASSERT_EQ(bounds.front(), 0);
+    ASSERT_EQ(bounds.back(), 101);
+    ASSERT_EQ(bounds[1], 17);
+    for (std::size_t t = 1; t + 1 < bounds.size(); ++t) {
+        ASSERT_LE(bounds[t + 1] - bounds[t], bounds[t] - bounds[t - 1]);
+        if (t + 2 < bounds.size()) {
+            ASSERT_GE(bounds[t + 1] - bounds[t], 4);
+        }
+    }
+    ASSERT_EQ(guidedRanges(0, 3, 4).size(), 1u);
+}
+
+
+TEST(PartitionTest, FirstTouchZeroesTheWholeMatrix) {
+    Arena arena;
+    Matrix M = allocateMatrix(arena, 13, 5);
+    fillMatrix(M, 7);
+    firstTouchRows(M);
+    for (std::size_t i = 0; i < M.storageSize(); ++i) {
+        ASSERT_EQ(M.data[i], 0);
+    }
+}
+
+
+/************************
+ * Threaded Kernel Test *
+ ************************/
+TEST(ThreadedKernelTest, MoreThreadsThanRowsGiveTheSameResult) {
+#ifdef _OPENMP
+    const int previous = omp_get_max_threads();
+    omp_set_num_threads(5);
+#endif
+    Arena storage, workspace;
+    Matrix A = fromNested(storage, {{1, 2, 3}, {4, 5, 6}});
+    Matrix B = fromNested(storage, {{7, 8}, {9, 10}, {11, 12}});
+    Matrix C = allocateMatrix(storage, 2, 2);
+    fillMatrix(C, -1);
+
+    multiplyBlocked(A, B, C, workspace);
+
+    std::vector<std::vector<int>> expected = {{58, 64}, {139, 154}};
+    ASSERT_EQ(toNested(C), expected);
+#ifdef _OPENMP
+    omp_set_num_threads(previous);
+#endif
+}
+
+
+/**********************
+ * Helper Thread Test *
+ **********************/
+TEST(HelperThreadTest, ProgressThreadIsNotConfinedToTheCpuOfThreadZero) {
+    // arrange: pin this thread to one cpu, as pinRankAndThreads does with OpenMP thread 0
+    cpu_set_t previous;
+    ASSERT_EQ(sched_getaffinity(0, sizeof(previous), &previous), 0);
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &previous)) {
+            cpus.push_back(cpu);
+        }
+    }
+    if (cpus.size() < 2) {
+        GTEST_SKIP() << "needs at least 2 cpus";
+    }
+    cpu_set_t first;
+    CPU_ZERO(&first);
+    CPU_SET(cpus[0], &first);
+    ASSERT_EQ(sched_setaffinity(0, sizeof(first), &first), 0);
+
+    // act
+    std::vector<int> inherited, given;
+    {
+        ProgressThread progress;
+        inherited = progress.cpus();
+    }
+    {
+        ProgressThread progress(cpus);
+        given = progress.cpus();
+    }
+    sched_setaffinity(0, sizeof(previous), &previous);
+
+    // assert
+    ASSERT_EQ(inherited, std::vector<int>{cpus[0]});
+    ASSERT_EQ(given, cpus);
+}
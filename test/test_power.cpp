@@ -0,0 +1,59 @@
+#include "kernels.h"
+#include "test_matrices.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+/**
+ * A^k with k - 1 products, wrapping modulo 2^32 like the kernels.
+ */
+Matrix repeatedProduct(Arena& arena, Arena& workspace, const Matrix& A, int k) {
+    Matrix R = allocateMatrix(arena, A.rows, A.cols);
+    multiplyPower(A, 1, R, workspace);
+    for (int step = 1; step < k; ++step) {
+        Matrix next = allocateMatrix(arena, A.rows, A.cols);
+        multiplyNaive(R, A, next);
+        R = next;
+    }
+    return R;
+}
+
+}
+
+
+/**************
+ * Power Test *
+ **************/
+TEST(PowerTest, MatchesRepeatedProducts) {
+    // arrange
+    Arena storage, workspace;
+    Matrix A = randomMatrix(storage, 37, 37, 1, -3, 3);
+    Matrix C = allocateMatrix(storage, 37, 37);
+
+    for (int k : {1, 2, 3, 5, 8, 13}) {
+        // act
+        multiplyPower(A, k, C, workspace);
+
+        // assert
+        ASSERT_EQ(toNested(C), toNested(repeatedProduct(storage, workspace, A, k))) << "k=" << k;
+    }
+}
+
+
+TEST(PowerTest, ZerothPowerIsTheIdentity) {
+    Arena storage, workspace;
+    Matrix A = randomMatrix(storage, 3, 3, 2, -3, 3);
+    Matrix C = allocateMatrix(storage, 3, 3);
+    multiplyPower(A, 0, C, workspace);
+    ASSERT_EQ(toNested(C), (std::vector<std::vector<int>>{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}));
+}
+
+
+TEST(PowerTest, CountsWalksInAGraph) {
+    Arena storage, workspace;
+    // directed 3-cycle: exactly one closed walk of length 3 from every vertex
+    Matrix A = fromNested(storage, {{0, 1, 0}, {0, 0, 1}, {1, 0, 0}});
+    Matrix C = allocateMatrix(storage, 3, 3);
+    multiplyPower(A, 300, C, workspace);
+    ASSERT_EQ(toNested(C), (std::vector<std::vector<int>>{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}));
+}
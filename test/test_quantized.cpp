@@ -0,0 +1,94 @@
+#include "kernels.h"
+#include "quantized.h"
+#include "test_matrices.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+void expectNaiveProduct(const Matrix& A, const Matrix& B, const Matrix& C) {
+    for (int i = 0; i < A.rows; ++i) {
+        for (int j = 0; j < B.cols; ++j) {
+            long long expected = 0;
+            for (int k = 0; k < A.cols; ++k) {
+                expected += static_cast<long long>(A.at(i, k)) * B.at(k, j);
+            }
+            ASSERT_EQ(C.at(i, j), static_cast<int>(expected)) << "at (" << i << ", " << j << ")";
+        }
+    }
+}
+
+BlockSizes smallBlocks() {
+    // blocks not multiple of the k groups and of the vector width, to hit every tail
+    BlockSizes blocks;
+    blocks.mc = 5;
+    blocks.kc = 13;
+    blocks.nc = 37;
+    return blocks;
+}
+
+}
+
+
+/*******************
+ * Range Scan Test *
+ *******************/
+TEST(RangeScanTest, SelectsTheNarrowestExactWidth) {
+    ASSERT_EQ(quantizedWidth({-128, 127}, {0, 1}), QuantizedWidth::Int8);
+    ASSERT_EQ(quantizedWidth({-129, 127}, {0, 1}), QuantizedWidth::Int16);
+    ASSERT_EQ(quantizedWidth({0, 1}, {-32768, 32767}), QuantizedWidth::Int16);
+    ASSERT_EQ(quantizedWidth({0, 32768}, {0, 1}), QuantizedWidth::Int32);
+
+    Arena arena;
+    Matrix M = fromNested(arena, {{3, -7, 2}, {100, 0, -1}});
+    const ValueRange range = scanRange(M);
+    ASSERT_EQ(range.min, -7);
+    ASSERT_EQ(range.max, 100);
+}
+
+
+/*************************
+ * Quantized Kernel Test *
+ *************************/
+TEST(QuantizedKernelTest, Int8MatchesNaiveProductIncludingExtremes) {
+    Arena storage, workspace;
+    Matrix A = randomMatrix(storage, 23, 45, 1, -128, 127);
+    Matrix B = randomMatrix(storage, 45, 53, 2, -128, 127);
+    A.at(0, 0) = -128;
+    B.at(0, 0) = -128;
+    A.at(1, 1) = 127;
+    B.at(1, 1) = 127;
+    Matrix C = allocateMatrix(storage, 23, 53);
+
+    multiplyInt8(A, B, C, workspace, smallBlocks());
+    expectNaiveProduct(A, B, C);
+    multiplyInt8(A, B, C, workspace);
+    expectNaiveProduct(A, B, C);
+}
+
+
+TEST(QuantizedKernelTest, Int16MatchesNaiveProductIncludingExtremes) {
+    Arena storage, workspace;
+    Matrix A = randomMatrix(storage, 19, 31, 3, -32768, 32767);
+    Matrix B = randomMatrix(storage, 31, 40, 4, -32768, 32767);
+    A.at(0, 0) = -32768;
+    A.at(0, 1) = -32768;
+    B.at(0, 0) = -32768;
+    B.at(1, 0) = -32768;
+    Matrix C = allocateMatrix(storage, 19, 40);
+
+    multiplyInt16(A, B, C, workspace, smallBlocks());
+    expectNaiveProduct(A, B, C);
+    multiplyInt16(A, B, C, workspace);
+    expectNaiveProduct(A, B, C);
+}
+
+
+TEST(QuantizedKernelTest, AutoFallsBackToInt32ForWideValues) {
+    Arena storage, workspace;
+    Matrix A = randomMatrix(storage, 7, 9, 5, -100000, 100000);
+    Matrix B = randomMatrix(storage, 9, 6, 6, -1000, 1000);
+    Matrix C = allocateMatrix(storage, 7, 6);
+
+    multiplyAuto(A, B, C, workspace);
+    expectNaiveProduct(A, B, C);
+}
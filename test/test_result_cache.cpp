@@ -0,0 +1,130 @@
+#include "hash.h"
+#include "result_cache.h"
+#include <dirent.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <gtest/gtest.h>
+
+namespace {
+
+std::string makeTempDirectory() {
+    char pattern[] = "/tmp/result_cache_test_XXXXXX";
+    return mkdtemp(pattern);
+}
+
+int countEntries(const std::string& directory) {
+    int count = 0;
+    DIR* dir = opendir(directory.c_str());
+    while (dirent* entry = readdir(dir)) {
+        const std::string name = entry->d_name;
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, ".mat") == 0) {
+            ++count;
+        }
+    }
+    closedir(dir);
+    return count;
+}
+
+}
+
+
+/*************
+ * Hash Test *
+ *************/
+TEST(HashTest, MatchesReferenceXXH64) {
+    // reference values of the xxHash library
+    ASSERT_EQ(hash64("", 0), 0xEF46DB3751D8E999ULL);
+    ASSERT_EQ(hash64("abc", 3), 0x44BC2CF5AD770999ULL);
+    const char* text = "Nobody inspects the spammish repetition";
+    ASSERT_EQ(hash64(text, std::strlen(text)), 0xFBCEA83C8A378BF1ULL);
+}
+
+
+TEST(HashTest, StreamingEqualsOneShot) {
+    unsigned char data[300];
+    for (int i = 0; i < 300; ++i) {
+        data[i] = static_cast<unsigned char>(i * 31);
+    }
+    Hash64 hash(7);
+    hash.update(data, 5);
+    hash.update(data + 5, 40);
+    hash.update(data + 45, 255);
+    ASSERT_EQ(hash.digest(), hash64(data, 300, 7));
+}
+
+
+TEST(HashTest, KeyDependsOnShapeNotOnlyOnElements) {
+    Arena arena;
+    Matrix A = fromNested(arena, {{1, 2, 3, 4}});
+    Matrix A2 = fromNested(arena, {{1, 2}, {3, 4}});
+    Matrix B = fromNested(arena, {{1}, {1}, {1}, {1}});
+    Matrix B2 = fromNested(arena, {{1, 1}, {1, 1}});
+    ASSERT_NE(operandKey(A, B).hex(), operandKey(A2, B2).hex());
+    ASSERT_EQ(operandKey(A, B).hex(), operandKey(A, B).hex());
+    ASSERT_EQ(operandKey(A, B).hex().size(), 32u);
+}
+
+
+/*********************
+ * Result Cache Test *
+ *********************/
+TEST(ResultCacheTest, StoreThenStreamRoundTrip) {
+    // arrange
+    Arena arena;
+    Matrix A = fromNested(arena, {{1, 2, 3}, {4, 5, 6}});
+    Matrix B = fromNested(arena, {{7, 8}, {9, 10}, {11, 12}});
+    Matrix C = fromNested(arena, {{58, 64}, {139, 154}});
+    ResultCache cache(makeTempDirectory(), 1 << 20);
+    const CacheKey key = operandKey(A, B);
+
+    // act
+    CachedResult before;
+    const bool hitBefore = cache.open(key, before);
+    ASSERT_TRUE(cache.store(key, C));
+    CachedResult after;
+    const bool hitAfter = cache.open(key, after);
+    std::ostringstream out;
+    const bool streamed = after.stream(out);
+
+    // assert
+    ASSERT_FALSE(hitBefore);
+    ASSERT_TRUE(hitAfter);
+    ASSERT_TRUE(streamed);
+    ASSERT_EQ(after.rows, 2);
+    ASSERT_EQ(after.cols, 2);
+    ASSERT_EQ(out.str(), "58 64 \n139 154 \n");
+    ASSERT_EQ(cache.stats().hits, 1u);
+    ASSERT_EQ(cache.stats().misses, 1u);
+}
+
+
+TEST(ResultCacheTest, EvictionKeepsTheMostRecentlyUsedEntries) {
+    // arrange: every entry is 8 + 8 + 4 * 100 bytes, the bound fits two of them
+    Arena arena;
+    const std::string directory = makeTempDirectory();
+    ResultCache cache(directory, 2 * 416);
+    Matrix C = allocateMatrix(arena, 10, 10);
+    fillMatrix(C, 1);
+    CacheKey keys[3];
+    for (int i = 0; i < 3; ++i) {
+        keys[i].low = i;
+        ASSERT_TRUE(cache.store(keys[i], C));
+        usleep(20000);
+    }
+
+    // act: touch the oldest entry, so the second one becomes the LRU
+    CachedResult touched;
+    ASSERT_TRUE(cache.open(keys[0], touched));
+    cache.evict();
+
+    // assert
+    CachedResult result;
+    ASSERT_EQ(countEntries(directory), 2);
+    ASSERT_TRUE(cache.open(keys[0], result));
+    ASSERT_FALSE(cache.open(keys[1], result));
+    ASSERT_TRUE(cache.open(keys[2], result));
+    ASSERT_EQ(cache.stats().evictions, 1u);
+}
@@ -0,0 +1,84 @@
+#include "semiring.h"
+#include "test_matrices.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+/**
+ * Entries in [-1000, 1000], about one in five replaced by the zero of S.
+ */
+template <typename S>
+Matrix semiringMatrix(Arena& arena, int rows, int cols, std::uint64_t seed) {
+    Matrix M = randomMatrix(arena, rows, cols, seed, -1000, 1000);
+    for (int i = 0; i < rows; ++i)
+        for (int j = 0; j < cols; ++j)
+            if (counterRandom(streamSeed(seed, 1), static_cast<std::uint64_t>(i) * cols + j) % 5 == 0)
+                M.at(i, j) = S::zero();
+    return M;
+}
+
+template <typename S>
+bool matchesReference(const Matrix& A, const Matrix& B, const Matrix& C) {
+    for (int i = 0; i < A.rows; ++i)
+        for (int j = 0; j < B.cols; ++j) {
+            int sum = S::zero();
+            for (int k = 0; k < A.cols; ++k)
+                sum = S::add(sum, S::mul(A.at(i, k), B.at(k, j)));
+            if (C.at(i, j) != sum)
+                return false;
+        }
+    return true;
+}
+
+template <typename S>
+void expectReference() {
+    Arena storage, workspace;
+    Matrix A = semiringMatrix<S>(storage, 37, 150, 1);
+    Matrix B = semiringMatrix<S>(storage, 150, 45, 2);
+    Matrix C = allocateMatrix(storage, 37, 45);
+    BlockSizes blocks;
+    blocks.kc = 64;
+    blocks.nc = 40;
+    multiplySemiring<S>(A, B, C, workspace, blocks);
+    EXPECT_TRUE(matchesReference<S>(A, B, C)) << S::name;
+}
+
+}
+
+
+/*****************
+ * Semiring Test *
+ *****************/
+TEST(SemiringTest, MatchesTheReferenceForEverySemiring) {
+    expectReference<PlusTimes>();
+    expectReference<MinPlus>();
+    expectReference<MaxPlus>();
+    expectReference<MaxMin>();
+}
+
+
+TEST(SemiringTest, SquaringADistanceMatrixGivesTwoHopDistances) {
+    // arrange
+    Arena storage, workspace;
+    const int inf = MinPlus::zero();
+    // 0 -> 1 (4), 1 -> 2 (1), 0 -> 2 (7), 2 -> 3 (2)
+    Matrix D = fromNested(storage, {{0, 4, 7, inf}, {inf, 0, 1, inf}, {inf, inf, 0, 2}, {inf, inf, inf, 0}});
+    Matrix D2 = allocateMatrix(storage, 4, 4);
+
+    // act
+    multiplySemiring(SemiringKind::MinPlus, D, D, D2, workspace);
+
+    // assert
+    ASSERT_EQ(toNested(D2), (std::vector<std::vector<int>>{
+                                {0, 4, 5, 9}, {inf, 0, 1, 3}, {inf, inf, 0, 2}, {inf, inf, inf, 0}}));
+}
+
+
+TEST(SemiringTest, ParsesNames) {
+    SemiringKind kind;
+    ASSERT_TRUE(parseSemiringKind("max-min", kind));
+    ASSERT_EQ(kind, SemiringKind::MaxMin);
+    ASSERT_STREQ(semiringName(kind), "max-min");
+    ASSERT_EQ(semiringZero(SemiringKind::MaxPlus), MaxPlus::zero());
+    ASSERT_FALSE(parseSemiringKind("min-min", kind));
+}
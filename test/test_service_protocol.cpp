@@ -0,0 +1,94 @@
+#include "service_protocol.h"
+#include <sys/socket.h>
+#include <unistd.h>
+#include <limits>
+#include <string>
+#include <gtest/gtest.h>
+
+
+/*************************
+ * Service Protocol Test *
+ *************************/
+TEST(ServiceProtocolTest, MatrixRoundTripDropsThePadding) {
+    // arrange
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    Arena arena;
+    Matrix A = fromNested(arena, {{1, -2, 3}, {4, 5, -6}});
+
+    // act
+    ASSERT_TRUE(sendMatrix(fds[0], A));
+    Matrix received;
+    ASSERT_TRUE(recvMatrix(fds[1], arena, received));
+
+    // assert
+    ASSERT_EQ(toNested(received), toNested(A));
+    ASSERT_EQ(received.stride, paddedStride(3));
+    close(fds[0]);
+    close(fds[1]);
+}
+
+
+TEST(ServiceProtocolTest, StringsLongerThanTheLimitAreRejected) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    std::string received;
+
+    ASSERT_TRUE(sendString(fds[0], "matrixA.txt"));
+    ASSERT_TRUE(recvString(fds[1], received));
+    ASSERT_EQ(received, "matrixA.txt");
+
+    ASSERT_TRUE(sendString(fds[0], std::string(100, 'x')));
+    ASSERT_FALSE(recvString(fds[1], received, 10));
+    close(fds[0]);
+    close(fds[1]);
+}
+
+
+TEST(ServiceProtocolTest, ClosedPeerIsAnErrorNotACrash) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    close(fds[1]);
+    ASSERT_FALSE(sendString(fds[0], std::string(1 << 20, 'x')));
+    std::uint32_t value;
+    ASSERT_FALSE(recvU32(fds[0], value));
+    close(fds[0]);
+}
+
+
+TEST(ServiceProtocolTest, OversizedMatricesAreRejectedBeforeAllocating) {
+    // arrange
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    Arena arena;
+    const std::int32_t huge[2] = {2147483647, 2147483647};
+    const std::int32_t overLimit[2] = {1000, 1000};
+
+    // act
+    ASSERT_TRUE(writeAll(fds[0], huge, sizeof(huge)));
+    Matrix received;
+    const bool hugeAccepted = recvMatrix(fds[1], arena, received);
+    ASSERT_TRUE(writeAll(fds[0], overLimit, sizeof(overLimit)));
+    const bool overLimitAccepted = recvMatrix(fds[1], arena, received, 1000 * 999);
+
+    // assert
+    ASSERT_FALSE(hugeAccepted);
+    ASSERT_FALSE(overLimitAccepted);
+    ASSERT_EQ(arena.stats().allocations, 0u);
+    ASSERT_TRUE(matrixFits(0, 2147483647 - 64, std::numeric_limits<std::size_t>::max()));
+    ASSERT_FALSE(matrixFits(3, -1));
+    ASSERT_FALSE(matrixFits(std::int64_t(1) << 40, 1));
+    close(fds[0]);
+    close(fds[1]);
+}
+
+
+TEST(ServiceProtocolTest, SilentPeerTimesOut) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    ASSERT_TRUE(setSocketTimeout(fds[1], 50));
+    std::uint32_t value;
+    ASSERT_FALSE(recvU32(fds[1], value));
+    close(fds[0]);
+    close(fds[1]);
+}
@@ -0,0 +1,60 @@
+#include "spsc_queue.h"
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+
+/*******************
+ * Spsc Queue Test *
+ ******************/
+TEST(SpscQueueTest, KeepsFifoOrderAcrossThreads) {
+    // arrange: a tiny ring so that the producer keeps finding it full
+    SpscQueue<int> queue(4);
+    std::vector<int> received;
+
+    // act
+    std::thread producer([&] {
+        for (int i = 0; i < 100000; ++i) {
+            while (!queue.tryPush(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    int value;
+    while (received.size() < 100000) {
+        if (queue.tryPop(value)) {
+            received.push_back(value);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+
+    // assert
+    for (int i = 0; i < 100000; ++i) {
+        ASSERT_EQ(received[i], i);
+    }
+    ASSERT_FALSE(queue.tryPop(value));
+}
+
+TEST(SpscQueueTest, FailsWhenFullOrEmpty) {
+    // arrange
+    SpscQueue<int> queue(3);
+    int value;
+
+    // act / assert: the capacity is rounded up to 4
+    ASSERT_EQ(queue.capacity(), 4u);
+    ASSERT_FALSE(queue.tryPop(value));
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(queue.tryPush(i));
+    }
+    ASSERT_FALSE(queue.tryPush(4));
+    ASSERT_TRUE(queue.tryPop(value));
+    ASSERT_EQ(value, 0);
+    ASSERT_TRUE(queue.tryPush(4));
+    for (int i = 1; i <= 4; ++i) {
+        ASSERT_TRUE(queue.tryPop(value));
+        ASSERT_EQ(value, i);
+    }
+    ASSERT_FALSE(queue.tryPop(value));
+}
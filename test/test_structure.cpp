@@ -0,0 +1,184 @@
+#include "kernels.h"
+#include "structure.h"
+#include <cstdlib>
+#include <string>
+#include <gtest/gtest.h>
+
+namespace {
+
+/**
+ * n x n matrix with nonzeros only where |i - j| is inside the band [-lower, upper].
+ */
+Matrix bandMatrix(Arena& arena, int n, int lower, int upper, bool symmetric = false) {
+    Matrix M = allocateMatrix(arena, n, n);
+    fillMatrix(M, 0);
+    for (int i = 0; i < n; ++i)
+        for (int j = 0; j < n; ++j)
+            if (i - j <= lower && j - i <= upper)
+                M.at(i, j) = symmetric ? (i + j) % 7 + 1 : (3 * i + j) % 7 + 1;
+    return M;
+}
+
+void expectNaiveProduct(const Matrix& A, const Matrix& B, const Matrix& C) {
+    for (int i = 0; i < A.rows; ++i) {
+        for (int j = 0; j < B.cols; ++j) {
+            int expected = 0;
+            for (int k = 0; k < A.cols; ++k) {
+                expected += A.at(i, k) * B.at(k, j);
+            }
+            ASSERT_EQ(C.at(i, j), expected) << "at (" << i << ", " << j << ")";
+        }
+    }
+}
+
+std::string multiplyAndCheck(const Matrix& A, const Matrix& B) {
+    Arena storage, workspace;
+    Matrix C = allocateMatrix(storage, A.rows, B.cols);
+    fillMatrix(C, 12345);
+    KernelReport report;
+    multiplyAuto(A, B, C, workspace, &report);
+    expectNaiveProduct(A, B, C);
+    return report.kernel;
+}
+
+}
+
+
+/****************************
+ * Structure Detection Test *
+ ****************************/
+TEST(StructureDetectionTest, ClassifiesTheUsualShapes) {
+    Arena arena;
+    ASSERT_EQ(describeStructure(detectStructure(bandMatrix(arena, 6, -10, -10)), 6), "zero");
+    Matrix I = bandMatrix(arena, 5, 0, 0);
+    for (int i = 0; i < 5; ++i) {
+        I.at(i, i) = 1;
+    }
+    ASSERT_EQ(describeStructure(detectStructure(I), 5), "identity");
+    ASSERT_EQ(describeStructure(detectStructure(bandMatrix(arena, 6, 0, 0)), 6), "diagonal");
+    ASSERT_EQ(describeStructure(detectStructure(bandMatrix(arena, 6, 5, 0)), 6), "lower-triangular");
+    ASSERT_EQ(describeStructure(detectStructure(bandMatrix(arena, 6, 0, 5)), 6), "upper-triangular");
+    ASSERT_EQ(describeStructure(detectStructure(bandMatrix(arena, 9, 1, 2)), 9), "banded(l=1,u=2)");
+    ASSERT_EQ(describeStructure(detectStructure(bandMatrix(arena, 6, 5, 5, true)), 6), "symmetric");
+    ASSERT_EQ(describeStructure(detectStructure(bandMatrix(arena, 6, 5, 5)), 6), "dense");
+}
+
+
+TEST(StructureDetectionTest, RowBlocksAreClassifiedWithTheirGlobalOffset) {
+    // rows 2..3 of the 5x5 identity
+    Arena arena;
+    Matrix block = fromNested(arena, {{0, 0, 1, 0, 0}, {0, 0, 0, 1, 0}});
+    const MatrixStructure s = detectStructure(block, 2);
+    ASSERT_TRUE(s.is(kIdentity));
+    ASSERT_FALSE(detectStructure(block).is(kDiagonal));
+    ASSERT_EQ(s.range.min, 0);
+    ASSERT_EQ(s.range.max, 1);
+}
+
+
+/**************************
+ * Structured Kernel Test *
+ **************************/
+TEST(StructuredKernelTest, EveryStructureGivesTheExactProduct) {
+    Arena arena;
+    const int n = 40;
+    Matrix dense = bandMatrix(arena, n, n, n);
+    Matrix I = bandMatrix(arena, n, 0, 0);
+    for (int i = 0; i < n; ++i) {
+        I.at(i, i) = 1;
+    }
+
+    ASSERT_STREQ(multiplyAndCheck(bandMatrix(arena, n, -n, -n), dense).c_str(), "zero-fill");
+    ASSERT_STREQ(multiplyAndCheck(I, dense).c_str(), "identity-copy");
+    ASSERT_STREQ(multiplyAndCheck(dense, I).c_str(), "identity-copy");
+    ASSERT_STREQ(multiplyAndCheck(bandMatrix(arena, n, 0, 0), dense).c_str(), "diagonal-scale");
+    ASSERT_STREQ(multiplyAndCheck(dense, bandMatrix(arena, n, 0, 0)).c_str(), "diagonal-scale");
+    // skipping half of the work (a triangle) or short rows (a narrow band of B) only pays
+    // against the int32 kernel
+    const int size = 200;
+    Matrix lower = bandMatrix(arena, n, n, 0);
+    Matrix wideDense = bandMatrix(arena, size, size, size);
+    ASSERT_STREQ(multiplyAndCheck(lower, dense).c_str(), "int8");
+    ASSERT_STREQ(multiplyAndCheck(wideDense, bandMatrix(arena, size, 2, 3)).c_str(), "int8");
+    for (int i = 0; i < size; ++i) {
+        for (int j = 0; j < size; ++j) {
+            if (i < n && j < n) {
+                lower.at(i, j) *= 100000;
+            }
+            wideDense.at(i, j) *= 100000;
+        }
+    }
+    ASSERT_STREQ(multiplyAndCheck(lower, dense).c_str(), "banded");
+    ASSERT_STREQ(multiplyAndCheck(wideDense, bandMatrix(arena, size, 2, 3)).c_str(), "banded");
+    Matrix S = bandMatrix(arena, n, n, n, true);
+    ASSERT_STREQ(multiplyAndCheck(S, S).c_str(), "symmetric-square");
+    ASSERT_STREQ(multiplyAndCheck(dense, dense).c_str(), "int8");
+}
+
+
+TEST(StructuredKernelTest, RectangularIdentityRows) {
+    // B made of the first 2 rows of the 3x3 identity: C is A followed by a zero column
+    Arena arena;
+    Matrix A = fromNested(arena, {{1, 2}, {3, 4}, {5, 6}});
+    Matrix B = fromNested(arena, {{1, 0, 0}, {0, 1, 0}});
+    ASSERT_STREQ(multiplyAndCheck(A, B).c_str(), "identity-copy");
+}
+
+
+TEST(StructuredKernelTest, SymmetricSquareClearsThePadding) {
+    // arrange
+    Arena arena, workspace;
+    Matrix S = bandMatrix(arena, 37, 37, 37, true);
+    Matrix C = allocateMatrix(arena, 37, 37);
+    fillMatrix(C, -1);
+
+    // act
+    KernelReport report;
+    multiplyAuto(S, S, C, workspace, &report);
+
+    // assert
+    ASSERT_STREQ(report.kernel, "symmetric-square");
+    for (int i = 0; i < C.rows; ++i) {
+        for (int j = C.cols; j < C.span(); ++j) {
+            ASSERT_EQ(C.row(i)[j], 0) << "at (" << i << ", " << j << ")";
+        }
+    }
+}
+
+
+TEST(StructuredKernelTest, BandedKernelIsLeftToTheInt32Case) {
+    const int n = 384;
+    Arena arena, workspace;
+    Matrix dense = bandMatrix(arena, n, n, n);
+    Matrix wideDense = bandMatrix(arena, n, n, n);
+    Matrix wideLower = bandMatrix(arena, n, n, 0);
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            wideDense.at(i, j) *= 100000;
+            wideLower.at(i, j) *= 100000;
+        }
+    }
+    struct Case {
+        Matrix A, B;
+        const char* kernel;
+    };
+    const Case cases[] = {
+        {bandMatrix(arena, n, n, 0), dense, "int8"},     // int8 triangle: half of the work left
+        {bandMatrix(arena, n, 8, 8), dense, "banded"},   // int8 band: 4% of the work left
+        {wideLower, wideDense, "banded"},                 // int32 triangle
+        {dense, bandMatrix(arena, n, 2, 40), "int8"},    // int8 band of B: short rows
+    };
+    Matrix C = allocateMatrix(arena, n, n);
+    Matrix expected = allocateMatrix(arena, n, n);
+
+    for (const Case& c : cases) {
+        // act
+        KernelReport report;
+        multiplyAuto(c.A, c.B, C, workspace, &report);
+        multiplyBlocked(c.A, c.B, expected, workspace);
+
+        // assert
+        ASSERT_STREQ(report.kernel, c.kernel);
+        ASSERT_EQ(toNested(C), toNested(expected)) << c.kernel;
+    }
+}
@@ -0,0 +1,82 @@
+#include "kernels.h"
+#include "test_matrices.h"
+#include "vector_kernels.h"
+#include <string>
+#include <gtest/gtest.h>
+
+namespace {
+
+std::string multiplyAndCheck(const Matrix& A, const Matrix& B) {
+    Arena storage, workspace;
+    Matrix C = allocateMatrix(storage, A.rows, B.cols);
+    fillMatrix(C, 12345);
+    const char* kernel = multiplyVectorShape(A, B, C, workspace);
+    if (kernel == nullptr) {
+        return "";
+    }
+    for (int i = 0; i < A.rows; ++i) {
+        for (int j = 0; j < B.cols; ++j) {
+            int expected = 0;
+            for (int k = 0; k < A.cols; ++k) {
+                expected += A.at(i, k) * B.at(k, j);
+            }
+            EXPECT_EQ(C.at(i, j), expected) << "at (" << i << ", " << j << ")";
+        }
+        for (int j = B.cols; j < C.stride; ++j) {
+            EXPECT_EQ(C.at(i, j), 0) << "padding at (" << i << ", " << j << ")";
+        }
+    }
+    return kernel;
+}
+
+}
+
+
+/**********************
+ * Vector Kernel Test *
+ **********************/
+TEST(VectorKernelTest, DotProduct) {
+    Arena arena;
+    ASSERT_EQ(multiplyAndCheck(randomMatrix(arena, 1, 1001, 1, -1000, 1000), randomMatrix(arena, 1001, 1, 2, -1000, 1000)), "dot");
+}
+
+
+TEST(VectorKernelTest, MatrixVector) {
+    Arena arena;
+    ASSERT_EQ(multiplyAndCheck(randomMatrix(arena, 133, 77, 1, -1000, 1000), randomMatrix(arena, 77, 1, 2, -1000, 1000)), "gemv");
+}
+
+
+TEST(VectorKernelTest, VectorMatrix) {
+    Arena arena;
+    ASSERT_EQ(multiplyAndCheck(randomMatrix(arena, 1, 77, 1, -1000, 1000), randomMatrix(arena, 77, 133, 2, -1000, 1000)), "gevm");
+    ASSERT_EQ(multiplyAndCheck(randomMatrix(arena, 1, 5, 1, -1000, 1000), randomMatrix(arena, 5, 3, 2, -1000, 1000)), "gevm");
+}
+
+
+TEST(VectorKernelTest, OuterProduct) {
+    Arena arena;
+    ASSERT_EQ(multiplyAndCheck(randomMatrix(arena, 133, 1, 1, -1000, 1000), randomMatrix(arena, 1, 77, 2, -1000, 1000)), "outer");
+}
+
+
+TEST(VectorKernelTest, OtherShapesAreLeftToTheGeneralKernels) {
+    Arena arena;
+    ASSERT_EQ(multiplyAndCheck(randomMatrix(arena, 2, 3, 1, -1000, 1000), randomMatrix(arena, 3, 2, 2, -1000, 1000)), "");
+}
+
+
+TEST(VectorKernelTest, MultiplyAutoPicksTheVectorKernels) {
+    // arrange
+    Arena storage, workspace;
+    Matrix A = randomMatrix(storage, 1, 300, 4, -1000, 1000);
+    Matrix B = randomMatrix(storage, 300, 40, 5, -1000, 1000);
+    Matrix C = allocateMatrix(storage, 1, 40);
+    KernelReport report;
+
+    // act
+    multiplyAuto(A, B, C, workspace, &report);
+
+    // assert
+    ASSERT_STREQ(report.kernel, "gevm");
+}
@@ -0,0 +1,59 @@
+#include "kernels.h"
+#include "test_matrices.h"
+#include "verify.h"
+#include <gtest/gtest.h>
+
+
+/******************
+ * Freivalds Test *
+ ******************/
+TEST(FreivaldsTest, AcceptsALargeRandomProduct) {
+    // arrange
+    Arena storage, workspace;
+    Matrix A = randomMatrix(storage, 700, 500, 1, -1000, 1000);
+    Matrix B = randomMatrix(storage, 500, 600, 2, -1000, 1000);
+    Matrix C = allocateMatrix(storage, 700, 600);
+    multiplyAuto(A, B, C, workspace);
+
+    // act
+    const bool verified = freivalds(A, B, C, workspace, 10);
+
+    // assert
+    ASSERT_TRUE(verified);
+}
+
+
+TEST(FreivaldsTest, AcceptsProductsThatWrapAround) {
+    Arena storage, workspace;
+    Matrix A = randomMatrix(storage, 60, 70, 3, -2000000000, 2000000000);
+    Matrix B = randomMatrix(storage, 70, 50, 4, -2000000000, 2000000000);
+    Matrix C = allocateMatrix(storage, 60, 50);
+    multiplyAuto(A, B, C, workspace);
+    ASSERT_TRUE(freivalds(A, B, C, workspace, 10));
+}
+
+
+TEST(FreivaldsTest, RejectsASingleWrongElement) {
+    // arrange
+    Arena storage, workspace;
+    Matrix A = randomMatrix(storage, 300, 200, 5, -100, 100);
+    Matrix B = randomMatrix(storage, 200, 250, 6, -100, 100);
+    Matrix C = allocateMatrix(storage, 300, 250);
+    multiplyAuto(A, B, C, workspace);
+
+    // act
+    C.at(123, 45) += 2;
+    const bool verified = freivalds(A, B, C, workspace, 20);
+
+    // assert
+    ASSERT_FALSE(verified);
+}
+
+
+TEST(FreivaldsTest, RejectsMismatchedShapes) {
+    Arena storage, workspace;
+    Matrix A = randomMatrix(storage, 3, 4, 7, -10, 10);
+    Matrix B = randomMatrix(storage, 4, 5, 8, -10, 10);
+    Matrix C = allocateMatrix(storage, 3, 4);
+    ASSERT_FALSE(freivalds(A, B, C, workspace, 1));
+}
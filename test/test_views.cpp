@@ -0,0 +1,152 @@
+#include "kernels.h"
+#include "structure.h"
+#include "test_matrices.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+const int kSentinel = -7;
+
+/**
+ * A copy of M in the middle of a larger matrix filled with kSentinel, returned as a view.
+ */
+Matrix embedded(Arena& arena, const Matrix& M, Matrix& parent) {
+    parent = allocateMatrix(arena, M.rows + 5, M.cols + 21);
+    fillMatrix(parent, kSentinel);
+    Matrix view = subMatrix(parent, 3, 17, M.rows, M.cols);
+    for (int i = 0; i < M.rows; ++i)
+        std::copy(M.row(i), M.row(i) + M.cols, view.row(i));
+    return view;
+}
+
+/**
+ * Every element of `parent` outside `view` still holds kSentinel, padding included.
+ */
+void expectUntouchedAround(const Matrix& parent, const Matrix& view) {
+    const int row0 = static_cast<int>((view.data - parent.data) / parent.stride);
+    const int col0 = static_cast<int>((view.data - parent.data) % parent.stride);
+    for (int i = 0; i < parent.rows; ++i)
+        for (int j = 0; j < parent.stride; ++j) {
+            const bool inside = i >= row0 && i < row0 + view.rows && j >= col0 && j < col0 + view.cols;
+            if (!inside) {
+                ASSERT_EQ(parent.row(i)[j], kSentinel) << "(" << i << ", " << j << ")";
+            }
+        }
+}
+
+void expectEqual(const Matrix& expected, const Matrix& actual) {
+    ASSERT_EQ(expected.rows, actual.rows);
+    ASSERT_EQ(expected.cols, actual.cols);
+    for (int i = 0; i < expected.rows; ++i)
+        for (int j = 0; j < expected.cols; ++j)
+            ASSERT_EQ(expected.at(i, j), actual.at(i, j)) << "(" << i << ", " << j << ")";
+}
+
+}
+
+
+/*******************
+ * Sub Matrix Test *
+ *******************/
+TEST(SubMatrixTest, SharesTheStorageOfTheParent) {
+    // arrange
+    Arena storage;
+    Matrix M = randomMatrix(storage, 10, 40, 1, -100, 100);
+
+    // act
+    Matrix view = subMatrix(M, 2, 5, 4, 30);
+    Matrix rows = subMatrix(M, 6, 0, 3, 40);
+
+    // assert
+    EXPECT_EQ(view.data, M.data + 2 * M.stride + 5);
+    EXPECT_EQ(view.stride, M.stride);
+    EXPECT_FALSE(view.padded);
+    EXPECT_EQ(view.span(), 30);
+    EXPECT_TRUE(rows.padded);
+    EXPECT_EQ(rows.span(), M.stride);
+    view.at(1, 2) = 12345;
+    EXPECT_EQ(M.at(3, 7), 12345);
+}
+
+TEST(SubMatrixTest, FillLeavesTheParentAlone) {
+    // arrange
+    Arena storage;
+    Matrix parent;
+    Matrix view = embedded(storage, randomMatrix(storage, 6, 9, 2, -100, 100), parent);
+
+    // act
+    fillMatrix(view, 4);
+
+    // assert
+    for (int i = 0; i < view.rows; ++i)
+        for (int j = 0; j < view.cols; ++j)
+            ASSERT_EQ(view.at(i, j), 4);
+    expectUntouchedAround(parent, view);
+}
+
+TEST(SubMatrixTest, KernelsReadAndWriteViews) {
+    // arrange
+    Arena storage, workspace;
+    Matrix A = randomMatrix(storage, 37, 53, 3, -100, 100);
+    Matrix B = randomMatrix(storage, 53, 29, 4, -100, 100);
+    Matrix expected = allocateMatrix(storage, 37, 29);
+    multiplyNaive(A, B, expected);
+    Matrix parentA, parentB;
+    Matrix viewA = embedded(storage, A, parentA);
+    Matrix viewB = embedded(storage, B, parentB);
+    BlockSizes blocks;
+    blocks.mc = 16;
+    blocks.kc = 24;
+    blocks.nc = 16;
+
+    for (int kernel = 0; kernel < 4; ++kernel) {
+        Matrix parentC;
+        Matrix C = embedded(storage, allocateMatrix(storage, 37, 29), parentC);
+        fillMatrix(C, 0);
+
+        // act
+        switch (kernel) {
+        case 0: multiplyNaive(viewA, viewB, C); break;
+        case 1: multiplyBlocked(viewA, viewB, C, workspace, blocks); break;
+        case 2: multiplyStrassen(viewA, viewB, C, workspace, 16, blocks); break;
+        default: multiplyAuto(viewA, viewB, C, workspace); break;
+        }
+
+        // assert
+        SCOPED_TRACE(kernel);
+        expectEqual(expected, C);
+        expectUntouchedAround(parentC, C);
+    }
+    expectUntouchedAround(parentA, viewA);
+    expectUntouchedAround(parentB, viewB);
+}
+
+TEST(SubMatrixTest, StructuredAndVectorKernelsWriteViews) {
+    // arrange
+    Arena storage, workspace;
+    Matrix identity = allocateMatrix(storage, 20, 20);
+    fillMatrix(identity, 0);
+    Matrix diagonal = allocateMatrix(storage, 20, 20);
+    fillMatrix(diagonal, 0);
+    for (int i = 0; i < 20; ++i) {
+        identity.at(i, i) = 1;
+        diagonal.at(i, i) = i - 10;
+    }
+    Matrix B = randomMatrix(storage, 20, 35, 5, -100, 100);
+    Matrix row = randomMatrix(storage, 1, 20, 6, -100, 100);
+
+    for (const Matrix* A : {&identity, &diagonal, &row}) {
+        Matrix expected = allocateMatrix(storage, A->rows, 35);
+        multiplyNaive(*A, B, expected);
+        Matrix parentC;
+        Matrix C = embedded(storage, allocateMatrix(storage, A->rows, 35), parentC);
+        fillMatrix(C, 0);
+
+        // act
+        multiplyAuto(*A, B, C, workspace);
+
+        // assert
+        expectEqual(expected, C);
+        expectUntouchedAround(parentC, C);
+    }
+}